@@ -59,6 +59,7 @@ public class Parameters extends ParameterComponent {
   public final ComputerBrailleTableParameter computerBrailleTable;
   public final LiteraryBrailleTableParameter literaryBrailleTable;
   public final MessageLocaleParameter messageLocale;
+  public final MemoryUsageParameter memoryUsage;
 
   public Parameters (ConnectionBase connection) {
     super();
@@ -95,6 +96,7 @@ public class Parameters extends ParameterComponent {
     computerBrailleTable = new ComputerBrailleTableParameter(connection);
     literaryBrailleTable = new LiteraryBrailleTableParameter(connection);
     messageLocale = new MessageLocaleParameter(connection);
+    memoryUsage = new MemoryUsageParameter(connection);
   }
 
   private final Parameter[] newParameterArray () {
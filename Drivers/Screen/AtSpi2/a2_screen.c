@@ -20,6 +20,7 @@
 #include "embed.h"
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -53,6 +54,12 @@
 #define ATSPI_STATE_ACTIVE 1
 #define ATSPI_STATE_FOCUSED 12
 
+#define A2_OBJECT_HASH_SIZE 0X100
+#define A2_OBJECT_CACHE_LIMIT 0X400
+#define A2_FIND_CONCURRENCY 8
+#define A2_FIND_LIMIT 0X2000
+#define A2_PARENT_DEPTH_LIMIT 0X40
+
 #ifdef HAVE_X11_KEYSYM_H
 #include <X11/keysym.h>
 #endif /* HAVE_X11_KEYSYM_H */
@@ -98,6 +105,16 @@ static ScreenContentQuality curQuality;
 static long curNumRows, curNumCols;
 static wchar_t **curRows;
 static long *curRowLengths;
+
+/* The row arrays grow geometrically so that adding a row seldom means
+ * reallocating them. The offset of each row within the text is remembered
+ * so that a position can be found by a binary search. Since text is usually
+ * changed near its end (typing into a terminal), only the offsets of the rows
+ * after the first changed one are recomputed, and only when next needed.
+ */
+static long curRowsSize;
+static long *curRowOffsets;
+static long curRowOffsetsValid;
 static long curCaret,curPosX,curPosY;
 
 static DBusConnection *bus = NULL;
@@ -241,12 +258,66 @@ static size_t my_mbslen(const char *s, size_t n) {
   return ret;
 }
 
-static void addRows(long pos, long num) {
+static int ensureRowsSize(long size) {
+  if (size <= curRowsSize) return 1;
+
+  long newSize = curRowsSize? curRowsSize: 0X10;
+  while (newSize < size) newSize <<= 1;
+
+  {
+    wchar_t **rows = realloc(curRows, newSize*sizeof(*curRows));
+    if (!rows) goto noMemory;
+    curRows = rows;
+  }
+
+  {
+    long *lengths = realloc(curRowLengths, newSize*sizeof(*curRowLengths));
+    if (!lengths) goto noMemory;
+    curRowLengths = lengths;
+  }
+
+  {
+    long *offsets = realloc(curRowOffsets, newSize*sizeof(*curRowOffsets));
+    if (!offsets) goto noMemory;
+    curRowOffsets = offsets;
+  }
+
+  curRowsSize = newSize;
+  return 1;
+
+noMemory:
+  logMallocError();
+  return 0;
+}
+
+static void invalidateRowOffsets(long row) {
+  if (row < 0) row = 0;
+  if (row < curRowOffsetsValid) curRowOffsetsValid = row;
+}
+
+static void updateRowOffsets(void) {
+  long y = curRowOffsetsValid;
+  long offset;
+
+  if (y > curNumRows) y = curNumRows;
+  offset = y? curRowOffsets[y-1] + curRowLengths[y-1]: 0;
+
+  while (y < curNumRows) {
+    curRowOffsets[y] = offset;
+    offset += curRowLengths[y];
+    y++;
+  }
+
+  curRowOffsetsValid = curNumRows;
+}
+
+static int addRows(long pos, long num) {
+  if (!ensureRowsSize(curNumRows + num)) return 0;
+  invalidateRowOffsets(pos);
   curNumRows += num;
-  curRows = realloc(curRows,curNumRows*sizeof(*curRows));
-  curRowLengths = realloc(curRowLengths,curNumRows*sizeof(*curRowLengths));
   memmove(curRows      +pos+num,curRows      +pos,(curNumRows-(pos+num))*sizeof(*curRows));
   memmove(curRowLengths+pos+num,curRowLengths+pos,(curNumRows-(pos+num))*sizeof(*curRowLengths));
+  return 1;
 }
 
 static void delRows(long pos, long num) {
@@ -256,8 +327,24 @@ static void delRows(long pos, long num) {
   memmove(curRows      +pos,curRows      +pos+num,(curNumRows-(pos+num))*sizeof(*curRows));
   memmove(curRowLengths+pos,curRowLengths+pos+num,(curNumRows-(pos+num))*sizeof(*curRowLengths));
   curNumRows -= num;
-  curRows = realloc(curRows,curNumRows*sizeof(*curRows));
-  curRowLengths = realloc(curRowLengths,curNumRows*sizeof(*curRowLengths));
+  invalidateRowOffsets(pos);
+}
+
+static void freeRows(void) {
+  long i;
+  if (curRows) {
+    for (i=0;i<curNumRows;i++)
+      free(curRows[i]);
+    free(curRows);
+  }
+  curRows = NULL;
+  free(curRowLengths);
+  curRowLengths = NULL;
+  free(curRowOffsets);
+  curRowOffsets = NULL;
+  curRowsSize = 0;
+  curRowOffsetsValid = 0;
+  curNumRows = 0;
 }
 
 static int
@@ -371,43 +458,168 @@ send_with_reply_and_block(DBusConnection *bus, DBusMessage *msg, int timeout_ms,
   return reply;
 }
 
+/* Asynchronous method calls
+ *
+ * Rather than blocking the whole of BRLTTY while an application answers, a
+ * method call can be sent with a handler which is called, from within the
+ * normal dispatching of messages, once its reply (or its timeout) arrives.
+ * The handler is given NULL if there's no usable reply. Outstanding calls are
+ * remembered so that they can all be cancelled when the driver is stopped.
+ */
+typedef void AsyncReplyHandler (DBusMessage *reply, void *data);
+
+typedef struct asyncCall {
+  struct asyncCall *prev;
+  struct asyncCall *next;
+  DBusPendingCall *pending;
+  AsyncReplyHandler *handler;
+  void *data;
+  const char *doing;
+} AsyncCall;
+
+static AsyncCall *asyncCalls = NULL;
+
+static void unlinkAsyncCall(AsyncCall *call) {
+  if (call->prev) call->prev->next = call->next;
+  else asyncCalls = call->next;
+  if (call->next) call->next->prev = call->prev;
+  call->prev = call->next = NULL;
+}
+
+static void asyncCallNotify(DBusPendingCall *pending, void *data) {
+  AsyncCall *call = data;
+  DBusMessage *reply = dbus_pending_call_steal_reply(pending);
+
+  unlinkAsyncCall(call);
+  dbus_pending_call_unref(pending);
+
+  if (!reply) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "no reply while %s", call->doing);
+  } else if (dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "error while %s: %s", call->doing, dbus_message_get_error_name(reply));
+    dbus_message_unref(reply);
+    reply = NULL;
+  }
+
+  call->handler(reply, call->data);
+  if (reply) dbus_message_unref(reply);
+  free(call);
+}
+
+/* Sends a method call message without waiting for its reply. This unrefs the
+ * message. NULL is returned (and the handler isn't called) if it can't be sent. */
+static AsyncCall *
+send_with_reply_async(DBusConnection *bus, DBusMessage *msg, int timeout_ms, const char *doing,
+                      AsyncReplyHandler *handler, void *data)
+{
+  AsyncCall *call;
+  DBusPendingCall *pending = NULL;
+
+  if (!(call = malloc(sizeof(*call)))) {
+    logMallocError();
+    dbus_message_unref(msg);
+    return NULL;
+  }
+
+  if (!dbus_connection_send_with_reply(bus, msg, &pending, timeout_ms) || !pending) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "can't send message while %s", doing);
+    dbus_message_unref(msg);
+    free(call);
+    return NULL;
+  }
+  dbus_message_unref(msg);
+
+  call->pending = pending;
+  call->handler = handler;
+  call->data = data;
+  call->doing = doing;
+
+  if (!dbus_pending_call_set_notify(pending, asyncCallNotify, call, NULL)) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "no memory while %s", doing);
+    dbus_pending_call_cancel(pending);
+    dbus_pending_call_unref(pending);
+    free(call);
+    return NULL;
+  }
+
+  call->prev = NULL;
+  if ((call->next = asyncCalls)) call->next->prev = call;
+  asyncCalls = call;
+  return call;
+}
+
+/* Forgets about a call whose reply is no longer wanted; its handler isn't called. */
+static void cancelAsyncCall(AsyncCall *call) {
+  unlinkAsyncCall(call);
+  dbus_pending_call_cancel(call->pending);
+  dbus_pending_call_unref(call->pending);
+  free(call);
+}
+
+/* Cancels every outstanding call, giving each handler NULL so that it can clean up. */
+static void cancelAsyncCalls(void) {
+  AsyncCall *call;
+
+  while ((call = asyncCalls)) {
+    unlinkAsyncCall(call);
+    dbus_pending_call_cancel(call->pending);
+    dbus_pending_call_unref(call->pending);
+    call->handler(NULL, call->data);
+    free(call);
+  }
+}
+
 static void findPosition(long position, long *px, long *py) {
-  long offset=0, newoffset, x, y;
+  long x, y;
   /* XXX: I don't know what they do with necessary combining accents */
-  for (y=0; y<curNumRows; y++) {
-    if ((newoffset = offset + curRowLengths[y]) > position)
-      break;
-    offset = newoffset;
-  }
-  if (y==curNumRows) {
-    if (!curNumRows) {
-      y = 0;
-      x = 0;
-    } else {
+  if (!curNumRows) {
+    y = 0;
+    x = 0;
+  } else {
+    long last = curNumRows-1;
+    updateRowOffsets();
+
+    if (position >= curRowOffsets[last] + curRowLengths[last]) {
       /* this _can_ happen, when deleting while caret is at the end of the
        * terminal: caret position is only updated afterwards... In the
        * meanwhile, keep caret at the end of last line. */
-      y = curNumRows-1;
+      y = last;
       x = curRowLengths[y];
+    } else {
+      /* the last row which starts at or before the position */
+      long low = 0, high = last;
+
+      while (low < high) {
+        long middle = (low + high + 1) / 2;
+
+        if (curRowOffsets[middle] <= position) {
+          low = middle;
+        } else {
+          high = middle - 1;
+        }
+      }
+
+      y = low;
+      x = position - curRowOffsets[y];
     }
-  } else
-    x = position-offset;
+  }
   *px = x;
   *py = y;
 }
 
 static long findCoordinates(long xx, long yy) {
-  long offset=0, y;
   /* XXX: I don't know what they do with necessary combining accents */
   if (yy >= curNumRows) {
     return -1;
   }
-  for (y=0; y<yy; y++) {
-    offset += curRowLengths[y];
-  }
-  if (xx >= curRowLengths[y])
-    xx = curRowLengths[y]-1;
-  return offset + xx;
+  updateRowOffsets();
+  if (xx >= curRowLengths[yy])
+    xx = curRowLengths[yy]-1;
+  return curRowOffsets[yy] + xx;
 }
 
 static void caretPosition(long caret) {
@@ -419,7 +631,6 @@ static void caretPosition(long caret) {
 }
 
 static void finiTerm(void) {
-  unsigned i;
   logMessage(LOG_CATEGORY(SCREEN_DRIVER),
              "end of term %s:%s",curSender,curPath);
   free(curSender);
@@ -429,15 +640,8 @@ static void finiTerm(void) {
   free(curRole);
   curRole = NULL;
   curPosX = curPosY = 0;
-  if (curRows) {
-    for (i=0;i<curNumRows;i++)
-      free(curRows[i]);
-    free(curRows);
-  }
-  curRows = NULL;
-  free(curRowLengths);
-  curRowLengths = NULL;
-  curNumCols = curNumRows = 0;
+  freeRows();
+  curNumCols = 0;
 }
 
 #define ROLE_TERMINAL "terminal"
@@ -459,180 +663,357 @@ isText (void) {
   return isRole(ROLE_TEXT);
 }
 
-/* Get the role of an AT-SPI2 object */
-static char *getRole(const char *sender, const char *path) {
-  const char *text;
-  char *res = NULL;
-  DBusMessage *msg, *reply;
-  DBusMessageIter iter;
+/* Sends a method call, with the given arguments, without waiting for its reply. */
+static AsyncCall *
+call_method_async(const char *sender, const char *path, const char *interface, const char *method,
+                  const char *doing, AsyncReplyHandler *handler, void *data, int first_arg_type, ...)
+{
+  DBusMessage *msg;
+  dbus_bool_t appended;
+  va_list args;
 
-  msg = new_method_call(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetRoleName");
+  msg = new_method_call(sender, path, interface, method);
   if (!msg)
     return NULL;
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting role");
+
+  va_start(args, first_arg_type);
+  appended = dbus_message_append_args_valist(msg, first_arg_type, args);
+  va_end(args);
+
+  if (!appended) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "no memory while making %s message", method);
+    dbus_message_unref(msg);
+    return NULL;
+  }
+
+  return send_with_reply_async(bus, msg, 1000, doing, handler, data);
+}
+
+static void ignoreReply(DBusMessage *reply, void *data) {
+}
+
+/* Returns a copy of the string in a reply, or NULL */
+static char *getReplyString(DBusMessage *reply, const char *method) {
+  DBusMessageIter iter;
+  const char *text;
+  char *res;
+
   if (!reply)
     return NULL;
 
   dbus_message_iter_init(reply, &iter);
   if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING) {
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "GetRoleName didn't return a string but '%c'", dbus_message_iter_get_arg_type(&iter));
-    goto out;
+               "%s didn't return a string but '%c'", method, dbus_message_iter_get_arg_type(&iter));
+    return NULL;
   }
   dbus_message_iter_get_basic(&iter, &text);
-  res = strdup(text);
 
-out:
-  dbus_message_unref(reply);
+  if (!(res = strdup(text)))
+    logMallocError();
   return res;
 }
 
-/* Get the get interfaces of an AT-SPI2 object */
-static int getHasTextInterface(const char *sender, const char *path) {
-  DBusMessage *msg, *reply;
+/* Checks the type of the property in a reply to Get, and points at its value */
+static int getReplyProperty(DBusMessage *reply, const char *property, int type, DBusMessageIter *iter_variant) {
   DBusMessageIter iter;
-  DBusMessageIter iter_array;
-  int ret = 0;
 
-  msg = new_method_call(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetInterfaces");
-  if (!msg)
-    return 0;
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting interfaces");
   if (!reply)
     return 0;
 
   dbus_message_iter_init(reply, &iter);
-  dbus_message_iter_recurse (&iter, &iter_array);
-  while (dbus_message_iter_get_arg_type (&iter_array) != DBUS_TYPE_INVALID)
-  {
-    const char *iface;
-    dbus_message_iter_get_basic (&iter_array, &iface);
+  if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_VARIANT) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "getting %s didn't return a variant but '%c'", property, dbus_message_iter_get_arg_type(&iter));
+    return 0;
+  }
+  dbus_message_iter_recurse(&iter, iter_variant);
+  if (dbus_message_iter_get_arg_type(iter_variant) != type) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "getting %s didn't return a '%c' but '%c'", property, type, dbus_message_iter_get_arg_type(iter_variant));
+    return 0;
+  }
+  return 1;
+}
 
-    if (!strcmp (iface, "org.a11y.atspi.Text"))
-    {
-      ret = 1;
-      goto out;
-    }
-    dbus_message_iter_next (&iter_array);
+/* The role and the state of each object which we've asked about are cached so
+ * that looking for the focused object, or going back to one, needn't ask again.
+ * An object's state is forgotten when it reports a state change, and its role
+ * when it reports a role change. Concurrent requests for the state of the same
+ * object share one method call.
+ */
+
+typedef void StateHandler (const char *sender, const char *path, const dbus_uint32_t *states, void *data);
+
+typedef struct stateWaiter {
+  struct stateWaiter *next;
+  StateHandler *handler;
+  void *data;
+} StateWaiter;
+
+typedef struct objectEntry {
+  struct objectEntry *next;
+  char *sender;
+  char *path;
+
+  char *role;
+  dbus_uint32_t states[2];
+  unsigned char haveStates:1;
+  unsigned char statesStale:1;
+
+  AsyncCall *statesCall;
+  StateWaiter *stateWaiters;
+
+  unsigned int busy;
+  unsigned int findGeneration;
+} ObjectEntry;
+
+static ObjectEntry *objectTable[A2_OBJECT_HASH_SIZE];
+static unsigned int objectCount = 0;
+
+static unsigned int hashObject(const char *sender, const char *path) {
+  uint32_t hash = UINT32_C(0X811C9DC5);
+  const unsigned char *byte;
+
+  for (byte = (const unsigned char *)sender; *byte; byte++)
+    hash = (hash ^ *byte) * UINT32_C(0X01000193);
+  hash *= UINT32_C(0X01000193);
+  for (byte = (const unsigned char *)path; *byte; byte++)
+    hash = (hash ^ *byte) * UINT32_C(0X01000193);
+
+  return hash % A2_OBJECT_HASH_SIZE;
+}
+
+static void freeObjectEntry(ObjectEntry *entry) {
+  StateWaiter *waiter;
+
+  while ((waiter = entry->stateWaiters)) {
+    entry->stateWaiters = waiter->next;
+    free(waiter);
   }
 
-out:
-  dbus_message_unref(reply);
-  return ret;
+  free(entry->sender);
+  free(entry->path);
+  free(entry->role);
+  free(entry);
+  objectCount--;
 }
 
-static char *getName(const char *sender, const char *path) {
-  const char *name;
-  char *res = NULL;
-  DBusMessage *msg, *reply = NULL;
-  const char *interface = SPI2_DBUS_INTERFACE_ACCESSIBLE;
-  const char *property = "Name";
-  DBusMessageIter iter, iter_variant;
+/* Forgets the objects which aren't being asked about. With force, forgets them all. */
+static void flushObjectCache(int force) {
+  unsigned int i;
 
-  msg = new_method_call(sender, path, DBUS_INTERFACE_PROPERTIES, "Get");
-  if (!msg)
-    return NULL;
-  dbus_message_append_args(msg, DBUS_TYPE_STRING, &interface, DBUS_TYPE_STRING, &property, DBUS_TYPE_INVALID);
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting name");
-  if (!reply)
+  for (i=0; i<A2_OBJECT_HASH_SIZE; i++) {
+    ObjectEntry **entry = &objectTable[i];
+
+    while (*entry) {
+      ObjectEntry *e = *entry;
+
+      if (!force && (e->busy || e->statesCall)) {
+        entry = &e->next;
+      } else {
+        *entry = e->next;
+        freeObjectEntry(e);
+      }
+    }
+  }
+}
+
+static ObjectEntry *findObjectEntry(const char *sender, const char *path, int create) {
+  unsigned int bucket = hashObject(sender, path);
+  ObjectEntry *entry;
+
+  for (entry = objectTable[bucket]; entry; entry = entry->next)
+    if (!strcmp(sender, entry->sender) && !strcmp(path, entry->path))
+      return entry;
+
+  if (!create)
     return NULL;
 
-  dbus_message_iter_init(reply, &iter);
-  if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_VARIANT) {
+  if (objectCount >= A2_OBJECT_CACHE_LIMIT) {
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "getName didn't return a variant but '%c'", dbus_message_iter_get_arg_type(&iter));
-    goto out;
+               "flushing object cache");
+    flushObjectCache(0);
   }
-  dbus_message_iter_recurse(&iter, &iter_variant);
-  if (dbus_message_iter_get_arg_type(&iter_variant) != DBUS_TYPE_STRING) {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "getName didn't return a variant but '%c'", dbus_message_iter_get_arg_type(&iter_variant));
-    goto out;
+
+  if (!(entry = calloc(1, sizeof(*entry))))
+    goto noMemory;
+  if (!(entry->sender = strdup(sender)))
+    goto noSender;
+  if (!(entry->path = strdup(path)))
+    goto noPath;
+
+  entry->next = objectTable[bucket];
+  objectTable[bucket] = entry;
+  objectCount++;
+  return entry;
+
+noPath:
+  free(entry->sender);
+noSender:
+  free(entry);
+noMemory:
+  logMallocError();
+  return NULL;
+}
+
+static void forgetObjectStates(const char *sender, const char *path) {
+  ObjectEntry *entry = findObjectEntry(sender, path, 0);
+
+  if (entry) {
+    entry->haveStates = 0;
+    if (entry->statesCall)
+      entry->statesStale = 1;
   }
-  dbus_message_iter_get_basic(&iter_variant, &name);
-  res = strdup(name);
+}
 
-out:
-  dbus_message_unref(reply);
-  return res;
+static void forgetObjectRole(const char *sender, const char *path) {
+  ObjectEntry *entry = findObjectEntry(sender, path, 0);
+
+  if (entry) {
+    free(entry->role);
+    entry->role = NULL;
+  }
 }
 
-/* Get the text of an AT-SPI2 object */
-static char *getText(const char *sender, const char *path) {
-  const char *text;
-  char *res = NULL;
-  DBusMessage *msg, *reply;
-  dbus_int32_t begin = 0;
-  dbus_int32_t end = -1;
-  DBusMessageIter iter;
+static void deliverObjectStates(ObjectEntry *entry, const dbus_uint32_t *states) {
+  StateWaiter *waiter;
 
-  msg = new_method_call(sender, path, SPI2_DBUS_INTERFACE_TEXT, "GetText");
-  if (!msg)
-    return NULL;
-  dbus_message_append_args(msg, DBUS_TYPE_INT32, &begin, DBUS_TYPE_INT32, &end, DBUS_TYPE_INVALID);
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting text");
-  if (!reply)
-    return NULL;
+  entry->busy++;
+  while ((waiter = entry->stateWaiters)) {
+    entry->stateWaiters = waiter->next;
+    waiter->handler(entry->sender, entry->path, states, waiter->data);
+    free(waiter);
+  }
+  entry->busy--;
+}
 
-  dbus_message_iter_init(reply, &iter);
-  if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING) {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "GetText didn't return a string but '%c'", dbus_message_iter_get_arg_type(&iter));
-    goto out;
+static void handleStatesReply(DBusMessage *reply, void *data) {
+  ObjectEntry *entry = data;
+  const dbus_uint32_t *states = NULL;
+
+  entry->statesCall = NULL;
+
+  if (reply) {
+    if (strcmp (dbus_message_get_signature (reply), "au") != 0) {
+      logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+                 "unexpected signature %s while getting active state", dbus_message_get_signature(reply));
+    } else {
+      DBusMessageIter iter, iter_array;
+      dbus_uint32_t *array;
+      int count;
+
+      dbus_message_iter_init (reply, &iter);
+      dbus_message_iter_recurse (&iter, &iter_array);
+      dbus_message_iter_get_fixed_array (&iter_array, &array, &count);
+
+      if (count != 2) {
+        logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+                   "unexpected signature %s while getting active state", dbus_message_get_signature(reply));
+      } else if (entry->statesStale) {
+        /* it changed while we were asking, so don't remember it */
+        states = array;
+      } else {
+        memcpy(entry->states, array, sizeof(entry->states));
+        entry->haveStates = 1;
+        states = entry->states;
+      }
+    }
   }
-  dbus_message_iter_get_basic(&iter, &text);
-  res = strdup(text);
 
-out:
-  dbus_message_unref(reply);
-  return res;
+  entry->statesStale = 0;
+  deliverObjectStates(entry, states);
 }
 
-/* Get the caret of an AT-SPI2 object */
-static dbus_int32_t getCaret(const char *sender, const char *path) {
-  dbus_int32_t res = -1;
-  DBusMessage *msg, *reply = NULL;
-  const char *interface = SPI2_DBUS_INTERFACE_TEXT;
-  const char *property = "CaretOffset";
-  DBusMessageIter iter, iter_variant;
+/* Get the state of an object, and give it (or NULL) to the handler */
+static void requestObjectStates(const char *sender, const char *path, StateHandler *handler, void *data) {
+  ObjectEntry *entry = findObjectEntry(sender, path, 1);
+  StateWaiter *waiter;
 
-  msg = new_method_call(sender, path, DBUS_INTERFACE_PROPERTIES, "Get");
-  if (!msg)
-    return -1;
-  dbus_message_append_args(msg, DBUS_TYPE_STRING, &interface, DBUS_TYPE_STRING, &property, DBUS_TYPE_INVALID);
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting caret");
-  if (!reply)
-    return -1;
+  if (!entry) {
+    handler(sender, path, NULL, data);
+    return;
+  }
 
-  dbus_message_iter_init(reply, &iter);
-  if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_VARIANT) {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "getCaret didn't return a variant but '%c'", dbus_message_iter_get_arg_type(&iter));
-    goto out;
+  if (entry->haveStates) {
+    entry->busy++;
+    handler(entry->sender, entry->path, entry->states, data);
+    entry->busy--;
+    return;
   }
-  dbus_message_iter_recurse(&iter, &iter_variant);
-  if (dbus_message_iter_get_arg_type(&iter_variant) != DBUS_TYPE_INT32) {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "getCaret didn't return an int32 but '%c'", dbus_message_iter_get_arg_type(&iter_variant));
-    goto out;
+
+  if (!(waiter = malloc(sizeof(*waiter)))) {
+    logMallocError();
+    handler(sender, path, NULL, data);
+    return;
   }
-  dbus_message_iter_get_basic(&iter_variant, &res);
-  logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-             "Got caret %d", res);
 
-out:
-  dbus_message_unref(reply);
-  return res;
-}
+  waiter->handler = handler;
+  waiter->data = data;
+  waiter->next = entry->stateWaiters;
+  entry->stateWaiters = waiter;
 
-/* Switched to a new terminal, restart from scratch */
-static void restartTerm(const char *sender, const char *path) {
-  char *text = getText(sender, path);
-  if (!text) {
-    text = getName(sender, path);
-    if (!text) return;
+  if (!entry->statesCall) {
+    entry->statesCall = call_method_async(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetState",
+                                          "getting state", handleStatesReply, entry,
+                                          DBUS_TYPE_INVALID);
+    if (!entry->statesCall)
+      deliverObjectStates(entry, NULL);
   }
+}
+
+/* Switching to a new object needs its text, caret, role, and interfaces. These
+ * are all asked for at once, and the switch is made when they've all been
+ * answered. Another focus event for the object being switched to doesn't ask
+ * again, and one for a different object supersedes it.
+ */
+typedef struct {
+  char *sender;
+  char *path;
+
+  AsyncCall *textCall;
+  AsyncCall *caretCall;
+  AsyncCall *roleCall;
+  AsyncCall *interfacesCall;
+
+  char *text;
+  char *role;
+  dbus_int32_t caret;
+  unsigned char hasText:1;
+} FocusRequest;
+
+static FocusRequest *focusRequest = NULL;
+
+static void freeFocusRequest(FocusRequest *request) {
+  free(request->sender);
+  free(request->path);
+  free(request->text);
+  free(request->role);
+  free(request);
+}
+
+static void cancelFocusRequest(void) {
+  FocusRequest *request = focusRequest;
+
+  if (!request)
+    return;
+  focusRequest = NULL;
+
+  if (request->textCall)
+    cancelAsyncCall(request->textCall);
+  if (request->caretCall)
+    cancelAsyncCall(request->caretCall);
+  if (request->roleCall)
+    cancelAsyncCall(request->roleCall);
+  if (request->interfacesCall)
+    cancelAsyncCall(request->interfacesCall);
+
+  freeFocusRequest(request);
+}
 
+/* Switched to a new terminal, restart from scratch. This frees the text. */
+static void restartTerm(const char *sender, const char *path, char *text, dbus_int32_t caret) {
   char *c,*d;
   const char *e;
   long i,len;
@@ -642,13 +1023,7 @@ static void restartTerm(const char *sender, const char *path) {
   logMessage(LOG_CATEGORY(SCREEN_DRIVER),
              "new term %s:%s with text %s", curSender, curPath, text);
 
-  if (curRows) {
-    for (i=0;i<curNumRows;i++)
-      free(curRows[i]);
-    free(curRows);
-  }
-  curNumRows = 0;
-  free(curRowLengths);
+  freeRows();
   c = text;
   while (*c) {
     curNumRows++;
@@ -658,8 +1033,11 @@ static void restartTerm(const char *sender, const char *path) {
   }
   logMessage(LOG_CATEGORY(SCREEN_DRIVER),
              "%ld rows",curNumRows);
-  curRows = malloc(curNumRows * sizeof(*curRows));
-  curRowLengths = malloc(curNumRows * sizeof(*curRowLengths));
+  if (!ensureRowsSize(curNumRows)) {
+    curNumRows = 0;
+    free(text);
+    return;
+  }
   i = 0;
   curNumCols = 0;
   for (c = text; *c; c = d+1) {
@@ -688,20 +1066,29 @@ static void restartTerm(const char *sender, const char *path) {
   }
   logMessage(LOG_CATEGORY(SCREEN_DRIVER),
              "%ld cols",curNumCols);
-  caretPosition(getCaret(sender, path));
+  caretPosition(caret);
   free(text);
 }
 
-/* Switched to a new object, check whether we want to read it, and if so, restart with it */
-static void tryRestartTerm(const char *sender, const char *path) {
+/* Everything about the new object is known, check whether we want to read it,
+ * and if so, restart with it */
+static void checkFocusRequest(FocusRequest *request) {
+  if (request->textCall || request->caretCall || request->roleCall || request->interfacesCall)
+    return;
+  focusRequest = NULL;
+
   if (curPath) finiTerm();
-  restartTerm(sender, path);
+  if (request->text) {
+    restartTerm(request->sender, request->path, request->text, request->caret);
+    request->text = NULL;
+  }
 
-  curRole = getRole(sender, path);
+  curRole = request->role;
+  request->role = NULL;
   logMessage(LOG_CATEGORY(SCREEN_DRIVER),
              "state changed focus to role %s", curRole);
 
-  curQuality = getHasTextInterface(sender, path)? SCQ_POOR: SCQ_NONE;
+  curQuality = request->hasText? SCQ_POOR: SCQ_NONE;
   unsigned char requested = typeFlags[TYPE_ALL];
 
   if (!requested) {
@@ -715,227 +1102,512 @@ static void tryRestartTerm(const char *sender, const char *path) {
   }
 
   if (requested) curQuality = SCQ_GOOD;     
+
+  freeFocusRequest(request);
+  updated = 1;
 }
 
-/* Get the state of an object */
-static dbus_uint32_t *getState(const char *sender, const char *path)
-{
-  DBusMessage *msg, *reply;
-  DBusMessageIter iter, iter_array;
-  dbus_uint32_t *states, *ret = NULL;
-  int count;
+static void handleFocusName(DBusMessage *reply, void *data) {
+  FocusRequest *request = data;
+  DBusMessageIter iter_variant;
+  const char *name;
 
-  msg = new_method_call(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetState");
-  if (!msg)
-    return NULL;
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting state");
-  if (!reply)
-    return NULL;
+  request->textCall = NULL;
+  if (getReplyProperty(reply, "Name", DBUS_TYPE_STRING, &iter_variant)) {
+    dbus_message_iter_get_basic(&iter_variant, &name);
+    if (!(request->text = strdup(name)))
+      logMallocError();
+  }
+  checkFocusRequest(request);
+}
 
-  if (strcmp (dbus_message_get_signature (reply), "au") != 0)
-  {
+/* When an object has no text, show its name */
+static void requestFocusName(FocusRequest *request) {
+  const char *interface = SPI2_DBUS_INTERFACE_ACCESSIBLE;
+  const char *property = "Name";
+
+  request->textCall = call_method_async(request->sender, request->path, DBUS_INTERFACE_PROPERTIES, "Get",
+                                        "getting name", handleFocusName, request,
+                                        DBUS_TYPE_STRING, &interface, DBUS_TYPE_STRING, &property,
+                                        DBUS_TYPE_INVALID);
+}
+
+static void handleFocusText(DBusMessage *reply, void *data) {
+  FocusRequest *request = data;
+
+  request->textCall = NULL;
+  if (!(request->text = getReplyString(reply, "GetText")))
+    requestFocusName(request);
+  checkFocusRequest(request);
+}
+
+static void handleFocusCaret(DBusMessage *reply, void *data) {
+  FocusRequest *request = data;
+  DBusMessageIter iter_variant;
+
+  request->caretCall = NULL;
+  if (getReplyProperty(reply, "CaretOffset", DBUS_TYPE_INT32, &iter_variant)) {
+    dbus_message_iter_get_basic(&iter_variant, &request->caret);
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "unexpected signature %s while getting active state", dbus_message_get_signature(reply));
-    goto out;
+               "Got caret %d", request->caret);
   }
-  dbus_message_iter_init (reply, &iter);
-  dbus_message_iter_recurse (&iter, &iter_array);
-  dbus_message_iter_get_fixed_array (&iter_array, &states, &count);
-  if (count != 2)
-  {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "unexpected signature %s while getting active state", dbus_message_get_signature(reply));
-    goto out;
+  checkFocusRequest(request);
+}
+
+static void handleFocusRole(DBusMessage *reply, void *data) {
+  FocusRequest *request = data;
+  ObjectEntry *entry;
+
+  request->roleCall = NULL;
+  if ((request->role = getReplyString(reply, "GetRoleName"))) {
+    if ((entry = findObjectEntry(request->sender, request->path, 1)) && !entry->role)
+      entry->role = strdup(request->role);
   }
-  ret = malloc(sizeof(*ret) * count);
-  memcpy(ret, states, sizeof(*ret) * count);
+  checkFocusRequest(request);
+}
 
-out:
-  dbus_message_unref(reply);
-  return ret;
+static void handleFocusInterfaces(DBusMessage *reply, void *data) {
+  FocusRequest *request = data;
+  DBusMessageIter iter;
+  DBusMessageIter iter_array;
+
+  request->interfacesCall = NULL;
+  if (reply) {
+    dbus_message_iter_init(reply, &iter);
+    dbus_message_iter_recurse (&iter, &iter_array);
+    while (dbus_message_iter_get_arg_type (&iter_array) != DBUS_TYPE_INVALID)
+    {
+      const char *iface;
+      dbus_message_iter_get_basic (&iter_array, &iface);
+
+      if (!strcmp (iface, "org.a11y.atspi.Text"))
+      {
+        request->hasText = 1;
+        break;
+      }
+      dbus_message_iter_next (&iter_array);
+    }
+  }
+  checkFocusRequest(request);
 }
 
-/* Check whether an ancestor of this object is active */
-static int checkActiveParent(const char *sender, const char *path) {
-  DBusMessage *msg, *reply;
-  DBusMessageIter iter, iter_variant, iter_struct;
-  int res = 0;
-  const char *interface = SPI2_DBUS_INTERFACE_ACCESSIBLE;
-  const char *property = "Parent";
-  dbus_uint32_t *states;
+static void abandonFind(void);
 
-  msg = new_method_call(sender, path, DBUS_INTERFACE_PROPERTIES, "Get");
-  if (!msg)
-    return 0;
-  dbus_message_append_args(msg, DBUS_TYPE_STRING, &interface, DBUS_TYPE_STRING, &property, DBUS_TYPE_INVALID);
-  reply = send_with_reply_and_block(bus, msg, 1000, "checking active object");
-  if (!reply)
-    return 0;
+/* Switched to a new object, find out about it */
+static void tryRestartTerm(const char *sender, const char *path) {
+  FocusRequest *request;
+
+  if ((request = focusRequest)) {
+    if (!strcmp(sender, request->sender) && !strcmp(path, request->path))
+      /* already switching to it */
+      return;
+    cancelFocusRequest();
+  }
+  abandonFind();
+
+  if (!(request = calloc(1, sizeof(*request))))
+    goto noMemory;
+  if (!(request->sender = strdup(sender)))
+    goto noSender;
+  if (!(request->path = strdup(path)))
+    goto noPath;
+  request->caret = -1;
+  focusRequest = request;
 
-  if (strcmp (dbus_message_get_signature (reply), "v") != 0)
   {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "unexpected signature %s while checking active object", dbus_message_get_signature(reply));
-    goto out;
+    dbus_int32_t begin = 0;
+    dbus_int32_t end = -1;
+
+    request->textCall = call_method_async(sender, path, SPI2_DBUS_INTERFACE_TEXT, "GetText",
+                                          "getting text", handleFocusText, request,
+                                          DBUS_TYPE_INT32, &begin, DBUS_TYPE_INT32, &end,
+                                          DBUS_TYPE_INVALID);
+    if (!request->textCall)
+      requestFocusName(request);
   }
 
-  dbus_message_iter_init (reply, &iter);
-  dbus_message_iter_recurse (&iter, &iter_variant);
-  dbus_message_iter_recurse (&iter_variant, &iter_struct);
-  dbus_message_iter_get_basic (&iter_struct, &sender);
-  dbus_message_iter_next (&iter_struct);
-  dbus_message_iter_get_basic (&iter_struct, &path);
+  {
+    const char *interface = SPI2_DBUS_INTERFACE_TEXT;
+    const char *property = "CaretOffset";
 
-  states = getState(sender, path);
-  if (states) {
-    res = (states[0] & (1<<ATSPI_STATE_ACTIVE)) != 0 || checkActiveParent(sender, path);
-    free(states);
-  } else {
-    res = 0;
+    request->caretCall = call_method_async(sender, path, DBUS_INTERFACE_PROPERTIES, "Get",
+                                           "getting caret", handleFocusCaret, request,
+                                           DBUS_TYPE_STRING, &interface, DBUS_TYPE_STRING, &property,
+                                           DBUS_TYPE_INVALID);
   }
 
-out:
-  dbus_message_unref(reply);
-  return res;
+  {
+    ObjectEntry *entry = findObjectEntry(sender, path, 0);
+
+    if (entry && entry->role) {
+      request->role = strdup(entry->role);
+    } else {
+      request->roleCall = call_method_async(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetRoleName",
+                                            "getting role", handleFocusRole, request,
+                                            DBUS_TYPE_INVALID);
+    }
+  }
+
+  request->interfacesCall = call_method_async(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetInterfaces",
+                                              "getting interfaces", handleFocusInterfaces, request,
+                                              DBUS_TYPE_INVALID);
+
+  checkFocusRequest(request);
+  return;
+
+noPath:
+  free(request->sender);
+noSender:
+  free(request);
+noMemory:
+  logMallocError();
 }
 
-/* Check whether this object is the focused object (which is way faster than
- * browsing all objects of the desktop) */
-static int reinitTerm(const char *sender, const char *path) {
-  dbus_uint32_t *states = getState(sender, path);
-  int active = 0;
+/* Looking for the focused object means walking the tree of objects from the
+ * registry down. Several objects are asked about at once, though not too many,
+ * and each object is only visited once, which also takes care of bogus
+ * applications which have children loops. A focus event makes a walk which is
+ * in progress pointless, so each walk has a generation, and replies for an
+ * earlier one are ignored.
+ */
+typedef struct findNode {
+  struct findNode *next;
+  unsigned int generation;
+  char *sender;
+  char *path;
+  unsigned char active:1;
+  unsigned char childrenOnly:1;
+} FindNode;
 
-  if (!states)
-    return 0;
+static unsigned int findGeneration = 0;
+static unsigned int findActive = 0;
+static unsigned int findCount = 0;
+static FindNode *findQueueHead = NULL;
+static FindNode *findQueueTail = NULL;
+
+static void freeFindNode(FindNode *node) {
+  free(node->sender);
+  free(node->path);
+  free(node);
+}
+
+static void abandonFind(void) {
+  FindNode *node;
+
+  findGeneration++;
+  while ((node = findQueueHead)) {
+    findQueueHead = node->next;
+    freeFindNode(node);
+  }
+  findQueueTail = NULL;
+}
+
+static int isCurrentFind(const FindNode *node) {
+  return node->generation == findGeneration;
+}
+
+static void startFindNode(FindNode *node);
 
-  /* Whether this widget is active */
-  active = (states[0] & (1<<ATSPI_STATE_ACTIVE)) != 0;
+static void finishFindNode(FindNode *node) {
+  int current = isCurrentFind(node);
 
-  if (states[0] & (1<<ATSPI_STATE_FOCUSED)) {
-    free(states);
+  freeFindNode(node);
+  findActive--;
+
+  while ((findActive < A2_FIND_CONCURRENCY) && (node = findQueueHead)) {
+    if (!(findQueueHead = node->next))
+      findQueueTail = NULL;
+    findActive++;
+    startFindNode(node);
+  }
+
+  if (current && !findActive && !findQueueHead)
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "%s %s is focused!", sender, path);
-    /* This widget is focused */
-    if (active) {
-      /* And it is active, we are done.  */
-      tryRestartTerm(sender, path);
-      return 1;
-    } else {
-      /* Check that a parent is active.  */
-      return checkActiveParent(sender, path);
-    }
+               "no focused object found among %u objects", findCount);
+}
+
+static void queueFindNode(const char *sender, const char *path, int active, int childrenOnly) {
+  FindNode *node;
+
+  if (findCount == A2_FIND_LIMIT) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "too many objects while looking for the focused one");
+    findCount++;
   }
+  if (findCount > A2_FIND_LIMIT)
+    return;
+  findCount++;
+
+  if (!(node = malloc(sizeof(*node))))
+    goto noMemory;
+  if (!(node->sender = strdup(sender)))
+    goto noSender;
+  if (!(node->path = strdup(path)))
+    goto noPath;
+
+  node->next = NULL;
+  node->generation = findGeneration;
+  node->active = active;
+  node->childrenOnly = childrenOnly;
+
+  if (findActive < A2_FIND_CONCURRENCY) {
+    findActive++;
+    startFindNode(node);
+  } else {
+    if (findQueueTail)
+      findQueueTail->next = node;
+    else
+      findQueueHead = node;
+    findQueueTail = node;
+  }
+  return;
 
-  free(states);
-  return 0;
+noPath:
+  free(node->sender);
+noSender:
+  free(node);
+noMemory:
+  logMallocError();
 }
 
 /* Try to find an active object among children of the given object */
-
-/* We need to take care of bogus applications which have children loops, so we
- * need to compare newly found children with the list of ancestors */
-struct pathList {
-  const char *sender;
-  const char *path;
-  struct pathList *prev;
-  int loop;
-};
-static int findTerm(const char *sender, const char *path, int active, int depth, struct pathList *list);
-static int recurseFindTerm(const char *sender, const char *path, int active, int depth, struct pathList *list) {
-  DBusMessage *msg, *reply;
+static void handleFindChildren(DBusMessage *reply, void *data) {
+  FindNode *node = data;
   DBusMessageIter iter, iter_array, iter_struct;
-  int res = 0;
 
-  msg = new_method_call(sender, path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetChildren");
-  if (!msg)
-    return 0;
-  reply = send_with_reply_and_block(bus, msg, 1000, "getting active object");
-  if (!reply)
-    return 0;
+  if (!isCurrentFind(node) || !reply)
+    goto done;
 
   if (strcmp (dbus_message_get_signature (reply), "a(so)") != 0)
   {
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
                "unexpected signature %s while getting active object", dbus_message_get_signature(reply));
-    goto out;
+    goto done;
   }
   dbus_message_iter_init(reply, &iter);
   dbus_message_iter_recurse (&iter, &iter_array);
   while (dbus_message_iter_get_arg_type (&iter_array) != DBUS_TYPE_INVALID)
   {
     const char *childsender, *childpath;
-    struct pathList *cur;
+    ObjectEntry *entry;
 
     dbus_message_iter_recurse (&iter_array, &iter_struct);
     dbus_message_iter_get_basic (&iter_struct, &childsender);
     dbus_message_iter_next (&iter_struct);
     dbus_message_iter_get_basic (&iter_struct, &childpath);
 
-    /* Make sure that the child is not the same as an ancestor, to avoid
+    /* Make sure that the child hasn't already been visited, to avoid
      * recursing indefinitely.  */
-    for (cur = list; cur; cur = cur->prev)
-      if (!strcmp(childsender, cur->sender) && !strcmp(childpath, cur->path))
-      {
-	/* Loop detected, avoid continuing looking at this part of the tree
-	which is not actually a tree! */
-	cur->loop = 1;
-	break;
-      }
-    if (! cur)
-    {
-      struct pathList me = {
-	.sender = sender,
-	.path = path,
-	.prev = list,
-      };
-      if (findTerm(childsender, childpath, active, depth, &me))
-      {
-	res = 1;
-	goto out;
-      }
-      if (me.loop) {
-        /* There is a loop up to us.  Avoid continuing looking here which may
-         * entail an exponential number of lookups. */
-	break;
-      }
+    entry = findObjectEntry(childsender, childpath, 1);
+    if (!entry || (entry->findGeneration != findGeneration)) {
+      if (entry)
+        entry->findGeneration = findGeneration;
+      queueFindNode(childsender, childpath, node->active, 0);
+
+      /* its state may have been cached, and it may have been the one */
+      if (!isCurrentFind(node))
+        break;
     }
 
     dbus_message_iter_next (&iter_array);
   }
 
-out:
-  dbus_message_unref(reply);
-  return res;
+done:
+  finishFindNode(node);
+}
+
+static void requestFindChildren(FindNode *node) {
+  if (call_method_async(node->sender, node->path, SPI2_DBUS_INTERFACE_ACCESSIBLE, "GetChildren",
+                        "getting active object", handleFindChildren, node,
+                        DBUS_TYPE_INVALID))
+    return;
+  finishFindNode(node);
 }
 
 /* Test whether this object is active, and if not recurse in its children */
-static int findTerm(const char *sender, const char *path, int active, int depth, struct pathList *list) {
-  dbus_uint32_t *states = getState(sender, path);
+static void handleFindStates(const char *sender, const char *path, const dbus_uint32_t *states, void *data) {
+  FindNode *node = data;
 
-  if (!states)
-    return 0;
+  if (!isCurrentFind(node) || !states) {
+    finishFindNode(node);
+    return;
+  }
 
   if (states[0] & (1<<ATSPI_STATE_ACTIVE))
     /* This application is active */
-    active = 1;
+    node->active = 1;
 
-  if (states[0] & (1<<ATSPI_STATE_FOCUSED) && active)
+  if (states[0] & (1<<ATSPI_STATE_FOCUSED) && node->active)
   {
     /* And this widget is focused */
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
                "%s %s is focused!", sender, path);
-    free(states);
     tryRestartTerm(sender, path);
-    return 1;
+    finishFindNode(node);
+    return;
   }
 
-  free(states);
-  return recurseFindTerm(sender, path, active, depth+1, list);
+  requestFindChildren(node);
+}
+
+static void startFindNode(FindNode *node) {
+  if (node->childrenOnly)
+    requestFindChildren(node);
+  else
+    requestObjectStates(node->sender, node->path, handleFindStates, node);
 }
 
 /* Find out currently focused terminal, starting from registry */
 static void initTerm(void) {
-  recurseFindTerm(SPI2_DBUS_INTERFACE_REG, SPI2_DBUS_PATH_ROOT, 0, 0, NULL);
+  abandonFind();
+  findCount = 0;
+  queueFindNode(SPI2_DBUS_INTERFACE_REG, SPI2_DBUS_PATH_ROOT, 0, 1);
+}
+
+/* Checking whether the previously focused object still is, and, if it isn't
+ * active itself, whether an ancestor of it is */
+typedef struct {
+  unsigned int generation;
+  unsigned int depth;
+  char *sender;
+  char *path;
+} ParentCheck;
+
+static void endParentCheck(ParentCheck *check) {
+  free(check->sender);
+  free(check->path);
+  free(check);
+}
+
+static void reinitFailed(void) {
+  logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+             "caching failed, restarting from scratch");
+  initTerm();
+}
+
+static void checkActiveParent(ParentCheck *check, const char *sender, const char *path);
+
+static void handleParentStates(const char *sender, const char *path, const dbus_uint32_t *states, void *data) {
+  ParentCheck *check = data;
+
+  if (check->generation == findGeneration) {
+    if (!states) {
+      reinitFailed();
+    } else if (states[0] & (1<<ATSPI_STATE_ACTIVE)) {
+      tryRestartTerm(check->sender, check->path);
+    } else {
+      checkActiveParent(check, sender, path);
+      return;
+    }
+  }
+
+  endParentCheck(check);
+}
+
+static void handleParent(DBusMessage *reply, void *data) {
+  ParentCheck *check = data;
+  DBusMessageIter iter, iter_variant, iter_struct;
+  const char *sender, *path;
+
+  if (check->generation != findGeneration)
+    goto done;
+
+  if (!reply) {
+    reinitFailed();
+    goto done;
+  }
+
+  if (strcmp (dbus_message_get_signature (reply), "v") != 0)
+  {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "unexpected signature %s while checking active object", dbus_message_get_signature(reply));
+    reinitFailed();
+    goto done;
+  }
+
+  dbus_message_iter_init (reply, &iter);
+  dbus_message_iter_recurse (&iter, &iter_variant);
+  dbus_message_iter_recurse (&iter_variant, &iter_struct);
+  dbus_message_iter_get_basic (&iter_struct, &sender);
+  dbus_message_iter_next (&iter_struct);
+  dbus_message_iter_get_basic (&iter_struct, &path);
+
+  requestObjectStates(sender, path, handleParentStates, check);
+  return;
+
+done:
+  endParentCheck(check);
+}
+
+/* Check whether an ancestor of this object is active */
+static void checkActiveParent(ParentCheck *check, const char *sender, const char *path) {
+  const char *interface = SPI2_DBUS_INTERFACE_ACCESSIBLE;
+  const char *property = "Parent";
+
+  if (check->depth++ < A2_PARENT_DEPTH_LIMIT) {
+    if (call_method_async(sender, path, DBUS_INTERFACE_PROPERTIES, "Get",
+                          "checking active object", handleParent, check,
+                          DBUS_TYPE_STRING, &interface, DBUS_TYPE_STRING, &property,
+                          DBUS_TYPE_INVALID))
+      return;
+  }
+
+  reinitFailed();
+  endParentCheck(check);
+}
+
+static void handleReinitStates(const char *sender, const char *path, const dbus_uint32_t *states, void *data) {
+  ParentCheck *check = data;
+
+  if (check->generation != findGeneration)
+    goto done;
+
+  if (states && (states[0] & (1<<ATSPI_STATE_FOCUSED))) {
+    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+               "%s %s is focused!", sender, path);
+    /* This widget is focused */
+    if (states[0] & (1<<ATSPI_STATE_ACTIVE)) {
+      /* And it is active, we are done.  */
+      tryRestartTerm(sender, path);
+    } else {
+      /* Check that a parent is active.  */
+      checkActiveParent(check, sender, path);
+      return;
+    }
+  } else {
+    reinitFailed();
+  }
+
+done:
+  endParentCheck(check);
+}
+
+/* Check whether this object is the focused object (which is way faster than
+ * browsing all objects of the desktop) */
+static void reinitTerm(const char *sender, const char *path) {
+  ParentCheck *check;
+
+  abandonFind();
+
+  if (!(check = malloc(sizeof(*check))))
+    goto noMemory;
+  if (!(check->sender = strdup(sender)))
+    goto noSender;
+  if (!(check->path = strdup(path)))
+    goto noPath;
+
+  check->generation = findGeneration;
+  check->depth = 0;
+  requestObjectStates(sender, path, handleReinitStates, check);
+  return;
+
+noPath:
+  free(check->sender);
+noSender:
+  free(check);
+noMemory:
+  logMallocError();
+  initTerm();
 }
 
 /* Handle incoming events */
@@ -992,7 +1664,17 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
     && !strcmp(member, "StateChanged")
     && !strcmp(detail, "focused");
 
+  if (!strcmp(interface, "Object")) {
+    if (!strcmp(member, "StateChanged")) {
+      forgetObjectStates(sender, path);
+    } else if (!strcmp(member, "PropertyChange") && !strcmp(detail, "accessible-role")) {
+      forgetObjectRole(sender, path);
+    }
+  }
+
   if (StateChanged_focused && !detail1) {
+    if (focusRequest && !strcmp(sender, focusRequest->sender) && !strcmp(path, focusRequest->path))
+      cancelFocusRequest();
     if (curSender && !strcmp(sender, curSender) && !strcmp(path, curPath))
       finiTerm();
   } else if (!strcmp(interface,"Focus") || (StateChanged_focused && detail1)) {
@@ -1019,6 +1701,7 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
       return;
     }
     findPosition(detail1,&x,&y);
+    invalidateRowOffsets(y);
     if (dbus_message_iter_get_arg_type(&iter_variant) != DBUS_TYPE_STRING) {
       logMessage(LOG_CATEGORY(SCREEN_DRIVER),
                  "ergl, not string but '%c'", dbus_message_iter_get_arg_type(&iter_variant));
@@ -1079,6 +1762,7 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
     logMessage(LOG_CATEGORY(SCREEN_DRIVER),
                "insert %d from %d",detail2,detail1);
     findPosition(detail1,&x,&y);
+    invalidateRowOffsets(y);
     if (dbus_message_iter_get_arg_type(&iter_variant) != DBUS_TYPE_STRING) {
       logMessage(LOG_CATEGORY(SCREEN_DRIVER),
                  "ergl, not string but '%c'", dbus_message_iter_get_arg_type(&iter_variant));
@@ -1098,7 +1782,7 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
     }
     if (x && (c = strchr(adding,'\n'))) {
       /* splitting line */
-      addRows(y,1);
+      if (!addRows(y,1)) goto noRows;
       semilen=my_mbslen(adding,c+1-adding);
       curRowLengths[y]=x+semilen;
       if (x+semilen-1>curNumCols)
@@ -1119,7 +1803,7 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
     }
     while ((c = strchr(adding,'\n'))) {
       /* adding lines */
-      addRows(y,1);
+      if (!addRows(y,1)) goto noRows;
       semilen=my_mbslen(adding,c+1-adding);
       curRowLengths[y]=semilen;
       if (semilen-1>curNumCols)
@@ -1134,7 +1818,7 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
       /* still length to add on the line following it */
       if (y==curNumRows) {
 	/* It won't insert ending \n yet */
-	addRows(y,1);
+	if (!addRows(y,1)) goto noRows;
 	curRows[y]=NULL;
 	curRowLengths[y]=0;
       }
@@ -1150,6 +1834,11 @@ static void AtSpi2HandleEvent(const char *interface, DBusMessage *message)
     return;
   }
   updated = 1;
+  return;
+
+noRows:
+  /* our copy of the text is now incomplete, so read it all again */
+  tryRestartTerm(curSender, curPath);
 }
 
 static int closeX = 1;
@@ -1522,17 +2211,16 @@ construct_AtSpi2Screen (void) {
   }
   if (!addWatches()) goto noWatches;
 
+  dbus_connection_set_watch_functions(bus, a2AddWatch, a2RemoveWatch, a2WatchToggled, NULL, NULL);
+  dbus_connection_set_timeout_functions(bus, a2AddTimeout, a2RemoveTimeout, a2TimeoutToggled, NULL, NULL);
+
+  /* the replies are handled as they arrive */
   if (!curPath) {
     initTerm();
-  } else if (!reinitTerm(curSender, curPath)) {
-    logMessage(LOG_CATEGORY(SCREEN_DRIVER),
-               "caching failed, restarting from scratch");
-    initTerm();
+  } else {
+    reinitTerm(curSender, curPath);
   }
 
-  dbus_connection_set_watch_functions(bus, a2AddWatch, a2RemoveWatch, a2WatchToggled, NULL, NULL);
-  dbus_connection_set_timeout_functions(bus, a2AddTimeout, a2RemoveTimeout, a2TimeoutToggled, NULL, NULL);
-
 #ifdef HAVE_PKG_X11
   closeX = 0;
   dpy = XOpenDisplay(NULL);
@@ -1583,6 +2271,10 @@ destruct_AtSpi2Screen (void) {
     clipboardContent = NULL;
   }
 #endif /* HAVE_PKG_X11 */
+  cancelFocusRequest();
+  abandonFind();
+  cancelAsyncCalls();
+  flushObjectCache(1);
   dbus_connection_remove_filter(bus, AtSpi2Filter, NULL);
   dbus_connection_close(bus);
   dbus_connection_unref(bus);
@@ -1672,18 +2364,14 @@ enum key_type_e {
 static int
 AtSpi2GenerateKeyboardEvent (dbus_uint32_t keysym, enum key_type_e key_type)
 {
-  DBusMessage *msg, *reply;
   const char *s = "";
 
-  msg = new_method_call(SPI2_DBUS_INTERFACE_REG, SPI2_DBUS_PATH_DEC, SPI2_DBUS_INTERFACE_DEC, "GenerateKeyboardEvent");
-  if (!msg)
-    return 0;
-  dbus_message_append_args(msg, DBUS_TYPE_INT32, &keysym, DBUS_TYPE_STRING, &s, DBUS_TYPE_UINT32, &key_type, DBUS_TYPE_INVALID);
-  reply = send_with_reply_and_block(bus, msg, 1000, "generating keyboard event");
-  if (!reply)
-    return 0;
-
-  return 1;
+  /* Events are delivered in the order in which they're sent, so there's no
+   * need to wait for each one to be acknowledged. */
+  return call_method_async(SPI2_DBUS_INTERFACE_REG, SPI2_DBUS_PATH_DEC, SPI2_DBUS_INTERFACE_DEC, "GenerateKeyboardEvent",
+                           "generating keyboard event", ignoreReply, NULL,
+                           DBUS_TYPE_INT32, &keysym, DBUS_TYPE_STRING, &s, DBUS_TYPE_UINT32, &key_type,
+                           DBUS_TYPE_INVALID) != NULL;
 }
 
 static int
@@ -50,6 +50,7 @@
 #include "charset.h"
 #include "scr_gpm.h"
 #include "system_linux.h"
+#include "memusage.h"
 
 typedef enum {
   PARM_CHARSET,
@@ -770,6 +771,13 @@ readScreenDevice (off_t offset, void *buffer, size_t size) {
 static unsigned char *screenCacheBuffer;
 static size_t screenCacheSize;
 
+static size_t cacheMemoryUsage = 0;
+
+static void
+updateCacheMemoryUsage (void) {
+  updateMemoryUsage(MEMORY_SCREEN_CACHES, &cacheMemoryUsage, (screenCacheSize + unicodeCacheSize));
+}
+
 static size_t
 readScreenCache (off_t offset, void *buffer, size_t size) {
   if (offset <= screenCacheSize) {
@@ -1454,6 +1462,7 @@ destruct_LinuxScreen (void) {
   unicodeCacheSize = 0;
   unicodeCacheUsed = 0;
 
+  updateCacheMemoryUsage();
   closeMainConsole();
 }
 
@@ -1588,12 +1597,13 @@ testTextMode (void) {
 static int
 refreshCache (void) {
   size_t size = refreshScreenBuffer(&screenCacheBuffer, &screenCacheSize);
+  updateCacheMemoryUsage();
   if (!size) return 0;
 
   if (unicodeEnabled) {
-    if (!refreshUnicodeCache(size)) {
-      return 0;
-    }
+    int refreshed = refreshUnicodeCache(size);
+    updateCacheMemoryUsage();
+    if (!refreshed) return 0;
   }
 
   return 1;
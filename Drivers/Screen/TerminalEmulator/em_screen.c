@@ -32,6 +32,7 @@
 #include "async_handle.h"
 #include "async_io.h"
 #include "embed.h"
+#include "memusage.h"
 
 typedef enum {
   PARM_DIRECTORY,
@@ -170,6 +171,7 @@ destruct_TerminalEmulatorScreen (void) {
   }
 
   if (cachedSegment) {
+    subtractMemoryUsage(MEMORY_SCREEN_CACHES, cachedSegment->segmentSize);
     free(cachedSegment);
     cachedSegment = NULL;
   }
@@ -181,7 +183,10 @@ driverDirectiveHandler_path (const char *const *operands) {
 
   if (path) {
     if (!screenSegment) {
-      accessSegmentForPath(path);
+      if (accessSegmentForPath(path)) {
+        // its updates so far haven't been (and won't be) notified
+        mainScreenUpdated();
+      }
     }
   }
 }
@@ -416,11 +421,23 @@ refresh_TerminalEmulatorScreen (void) {
   if (cachedSegment) {
     if (cachedSegment->segmentSize != size) {
       logMessage(LOG_CATEGORY(SCREEN_DRIVER), "deallocating old screen cache");
+      subtractMemoryUsage(MEMORY_SCREEN_CACHES, cachedSegment->segmentSize);
       free(cachedSegment);
       cachedSegment = NULL;
     }
   }
 
+  if (HAVE_SCREEN_SEGMENT_FIELD(screenSegment, updateNumber)) {
+    // acknowledge before copying so that a concurrent update is notified
+    clearScreenSegmentFlags(screenSegment, SCREEN_SEGMENT_FLAG_UPDATED);
+
+    if (cachedSegment) {
+      if (cachedSegment->updateNumber == screenSegment->updateNumber) {
+        return 1;
+      }
+    }
+  }
+
   if (!cachedSegment) {
     logMessage(LOG_CATEGORY(SCREEN_DRIVER), "allocating new screen cache");
 
@@ -428,6 +445,8 @@ refresh_TerminalEmulatorScreen (void) {
       logMallocError();
       return 0;
     }
+
+    addMemoryUsage(MEMORY_SCREEN_CACHES, size);
   }
 
   memcpy(cachedSegment, screenSegment, size);
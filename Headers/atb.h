@@ -35,6 +35,8 @@ extern void destroyAttributesTable (AttributesTable *table);
 extern char *ensureAttributesTableExtension (const char *path);
 extern char *makeAttributesTablePath (const char *directory, const char *name);
 
+extern AttributesTable *compileNamedAttributesTable (const char *directory, const char *name);
+extern void installAttributesTable (AttributesTable *table);
 extern int replaceAttributesTable (const char *directory, const char *name);
 
 extern unsigned char convertAttributesToDots (AttributesTable *table, unsigned char attributes);
@@ -39,6 +39,7 @@ extern int appendClipboardContentUTF8 (ClipboardObject *cpb, const char *text);
 
 extern const wchar_t *getClipboardContent (ClipboardObject *cpb, size_t *length);
 extern char *getClipboardContentUTF8 (ClipboardObject *cpb);
+extern const char *getClipboardContentText (ClipboardObject *cpb); /* UTF-8, valid until the content changes */
 extern size_t getClipboardContentLength (ClipboardObject *cpb);
 
 static inline int
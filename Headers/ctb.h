@@ -34,10 +34,18 @@ extern void unlockContractionTable (void);
 extern ContractionTable *compileContractionTable (const char *name);
 extern void destroyContractionTable (ContractionTable *table);
 
+/* A duplicate shares the compiled rules of its original (which must outlive
+ * it) but has its own character and translation caches, so each thread can
+ * contract with its own duplicate. Only native tables can be duplicated.
+ */
+extern ContractionTable *duplicateContractionTable (ContractionTable *table);
+
 extern char *ensureContractionTableExtension (const char *path);
 extern char *makeContractionTablePath (const char *directory, const char *name);
 
 extern char *getContractionTableForLocale (const char *directory);
+extern ContractionTable *compileNamedContractionTable (const char *directory, const char *name);
+extern void installContractionTable (ContractionTable *table);
 extern int replaceContractionTable (const char *directory, const char *name);
 
 extern void contractText (
@@ -50,6 +58,21 @@ extern void contractText (
   int cursorOffset /* Position of coursor in source */
 );
 
+typedef struct {
+  unsigned long int cacheHits;
+  unsigned long int cacheMisses;
+
+  /* only those made to grow the translation cache and the character array */
+  unsigned long int bufferAllocations;
+} ContractionTableStatistics;
+
+extern void getContractionTableStatistics (ContractionTable *table, ContractionTableStatistics *statistics);
+extern void resetContractionTableStatistics (ContractionTable *table);
+
+/* Forget every remembered translation (but keep the buffers). */
+extern void clearContractionTableCache (ContractionTable *table);
+extern unsigned int getContractionTableCacheSize (void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -27,6 +27,7 @@ typedef struct DataAreaStruct DataArea;
 extern DataArea *newDataArea (void);
 extern void destroyDataArea (DataArea *area);
 extern void resetDataArea (DataArea *area);
+extern void shrinkDataArea (DataArea *area);
 
 typedef unsigned long int DataOffset;
 extern int allocateDataItem (DataArea *area, DataOffset *offset, size_t size, size_t alignment);
@@ -29,6 +29,7 @@ extern "C" {
 
 extern int setBaseDataVariables (const VariableInitializer *initializers);
 extern int setTableDataVariables (const char *tableExtension, const char *subtableExtension);
+extern void releaseDataVariables (void);
 
 extern FILE *openDataFile (const char *path, const char *mode, int optional);
 
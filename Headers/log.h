@@ -81,6 +81,8 @@ typedef enum {
   LOG_CATEGORY_INDEX(SPEECH_DRIVER),
   LOG_CATEGORY_INDEX(SCREEN_DRIVER),
 
+  LOG_CATEGORY_INDEX(MEMORY_USAGE),
+
   LOG_CATEGORY_COUNT /* must be last */
 } LogCategoryIndex;
 
@@ -96,6 +98,21 @@ extern unsigned char categoryLogLevel;
 extern unsigned char logCategoryFlags[LOG_CATEGORY_COUNT];
 #define LOG_CATEGORY_FLAG(name) logCategoryFlags[LOG_CATEGORY_INDEX(name)]
 
+#define LOG_CATEGORY_BIT(name) (1UL << LOG_CATEGORY_INDEX(name))
+#ifndef LOG_EXCLUDED_CATEGORIES
+#define LOG_EXCLUDED_CATEGORIES 0
+#endif /* LOG_EXCLUDED_CATEGORIES */
+
+static inline int
+testLogLevel (int level) {
+  unsigned int category = level >> LOG_LEVEL_WIDTH;
+  if (!category) return 1;
+
+  category -= 1;
+  if (LOG_EXCLUDED_CATEGORIES & (1UL << category)) return 0;
+  return logCategoryFlags[category];
+}
+
 extern void openLogFile (const char *path);
 extern void closeLogFile (void);
 
@@ -112,6 +129,13 @@ extern int logMessage (int level, const char *format, ...) PRINTF(2, 3);
 extern int vlogMessage (int level, const char *format, va_list *arguments);
 
 extern int logBytes (int level, const char *label, const void *data, size_t length, ...) PRINTF(2, 5);
+
+/* Check a message's category inline so that, when it isn't enabled (or has
+ * been compiled out), the arguments aren't even evaluated. The level may be
+ * evaluated twice so it mustn't have side effects.
+ */
+#define logMessage(level, ...) (testLogLevel((level))? (logMessage)((level), __VA_ARGS__): 0)
+#define logBytes(level, ...) (testLogLevel((level))? (logBytes)((level), __VA_ARGS__): 0)
 extern int logSymbol (int level, void *address, const char *format, ...) PRINTF(3, 4);
 
 extern int logActionProblem (int level, int error, const char *action);
@@ -40,8 +40,14 @@ extern unsigned int getLogEntryCount (const LogEntry *entry);
 extern int pushLogEntry (LogEntry **head, const char *text, LogEntryPushOptions options);
 extern int popLogEntry (LogEntry **head);
 
-extern const LogEntry *getNewestLogMessage (int freeze);
+#define LOG_MESSAGE_HISTORY_ENTRY_LIMIT 100
+#define LOG_MESSAGE_HISTORY_BYTE_LIMIT 0X8000
+
 extern void pushLogMessage (const char *message);
+extern int setLogMessageHistoryLimits (unsigned int entries, size_t bytes);
+
+typedef int LogEntryHandler (const LogEntry *entry, void *data);
+extern int processNewLogMessages (unsigned long *sequence, LogEntryHandler *handleLogEntry, void *data);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,50 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+#ifndef BRLTTY_INCLUDED_MEMUSAGE
+#define BRLTTY_INCLUDED_MEMUSAGE
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef enum {
+  MEMORY_TABLES,
+  MEMORY_SCREEN_CACHES,
+  MEMORY_API_CONNECTIONS,
+  MEMORY_QUEUES,
+  MEMORY_LOG_HISTORY,
+  MEMORY_CLIPBOARD,
+
+  MEMORY_COMPONENT_COUNT /* must be last */
+} MemoryComponent;
+
+extern const char *getMemoryComponentName (MemoryComponent component);
+
+extern void addMemoryUsage (MemoryComponent component, size_t size);
+extern void subtractMemoryUsage (MemoryComponent component, size_t size);
+extern void updateMemoryUsage (MemoryComponent component, size_t *accounted, size_t size);
+
+extern size_t getMemoryUsage (MemoryComponent component);
+extern size_t getMemoryUsagePeak (MemoryComponent component);
+extern void logMemoryUsage (const char *reason);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_MEMUSAGE */
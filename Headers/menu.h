@@ -33,8 +33,10 @@ typedef struct {
 
 extern Menu *newMenu (void);
 extern void destroyMenu (Menu *menu);
+extern void removeMenuItems (Menu *menu, unsigned int index);
 
 extern MenuItem *newTextMenuItem (Menu *menu, const MenuString *name, const char *text);
+extern void setMenuItemText (MenuItem *item, const char *text);
 
 typedef void NumericMenuItemFormatter (
   Menu *menu, unsigned char value,
@@ -180,6 +180,7 @@ typedef struct {
 
   unsigned char wordWrap;
   unsigned char capitalizationMode;
+  unsigned char wrapContractedLine;
   unsigned char startSelectionWithRoutingKey;
 
   unsigned char speechUppercaseIndicator;
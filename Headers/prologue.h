@@ -25,6 +25,8 @@ extern "C" {
 
 #undef HAVE_BUILTIN_POPCOUNT
 #undef HAVE_SYNC_SYNCHRONIZE
+#undef HAVE_SYNC_COMPARE_AND_SWAP
+#undef HAVE_SYNC_ADD_AND_FETCH
 
 #ifdef __has_builtin
 #if __has_builtin(__builtin_popcount)
@@ -34,6 +36,18 @@ extern "C" {
 #if __has_builtin(__sync_synchronize)
 #define HAVE_SYNC_SYNCHRONIZE
 #endif /* __has_builtin(__sync_synchronize) */
+
+#if __has_builtin(__sync_val_compare_and_swap)
+#define HAVE_SYNC_COMPARE_AND_SWAP
+#endif /* __has_builtin(__sync_val_compare_and_swap) */
+
+#if __has_builtin(__sync_add_and_fetch) && __has_builtin(__sync_sub_and_fetch)
+#define HAVE_SYNC_ADD_AND_FETCH
+#endif /* __has_builtin(__sync_add_and_fetch) */
+
+#if __has_builtin(__sync_fetch_and_or) && __has_builtin(__sync_fetch_and_and)
+#define HAVE_SYNC_FETCH_AND_OR
+#endif /* __has_builtin(__sync_fetch_and_or) */
 #endif /* __has_builtin */
 
 #ifndef HAVE_SYNC_SYNCHRONIZE
@@ -59,6 +59,7 @@ extern void ptyDeleteLines (unsigned int count);
 extern void ptyInsertCharacters (unsigned int count);
 extern void ptyDeleteCharacters (unsigned int count);
 extern void ptyAddCharacter (unsigned char character);
+extern size_t ptyAddText (const unsigned char *text, size_t count);
 
 extern void ptySetCursorVisibility (unsigned int visibility);
 extern void ptySetAttributes (attr_t attributes);
@@ -72,6 +73,7 @@ extern void ptyClearToEndOfLine (void);
 extern void ptyClearToBeginningOfLine (void);
 
 extern void ptySetScreenLogLevel (unsigned char level);
+extern void ptySetScreenUpdateInterval (int milliseconds);
 
 #ifdef __cplusplus
 }
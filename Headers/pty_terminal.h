@@ -39,6 +39,8 @@ extern void ptySetLogTerminalOutput (int yes);
 extern void ptySetLogTerminalSequences (int yes);
 extern void ptySetLogUnexpectedTerminalIO (int yes);
 
+extern void ptySetTerminalUpdateInterval (int milliseconds);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
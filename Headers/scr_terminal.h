@@ -68,8 +68,23 @@ typedef struct {
   uint32_t screenNumber;
   uint32_t commonFlags;
   uint32_t privateFlags;
+
+  uint32_t updateNumber;
 } ScreenSegmentHeader;
 
+/* The emulator only sends TERM_MSG_SEGMENT_UPDATED when it sets this flag,
+ * i.e. for the first of a burst of updates, and the driver clears it before
+ * it copies the segment so that the next update is notified again.
+ */
+#define SCREEN_SEGMENT_FLAG_UPDATED 0X01
+
+extern int testScreenSegmentField (const ScreenSegmentHeader *segment, size_t offset);
+#define HAVE_SCREEN_SEGMENT_FIELD(segment, field) \
+  testScreenSegmentField((segment), (offsetof(ScreenSegmentHeader, field) + sizeof((segment)->field)))
+
+extern uint32_t setScreenSegmentFlags (ScreenSegmentHeader *segment, uint32_t flags);
+extern uint32_t clearScreenSegmentFlags (ScreenSegmentHeader *segment, uint32_t flags);
+
 extern int getScreenSegment (int *identifier, key_t key);
 extern ScreenSegmentHeader *attachScreenSegment (int identifier);
 extern int detachScreenSegment (ScreenSegmentHeader *segment);
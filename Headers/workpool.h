@@ -0,0 +1,65 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_WORKPOOL
+#define BRLTTY_INCLUDED_WORKPOOL
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* A work pool processes a stream of independent pieces of input on a set of
+ * worker threads, and writes their results out in the order in which they
+ * were submitted. Only a few pieces may be outstanding at any time, so a
+ * submitter which gets ahead of the workers (or of the output) is made to
+ * wait.
+ */
+
+typedef struct WorkPoolStruct WorkPool;
+typedef struct WorkPoolOutputStruct WorkPoolOutput;
+
+extern int appendWorkPoolOutput (WorkPoolOutput *output, const void *bytes, size_t count);
+
+#define WORK_POOL_PROCESS_FUNCTION(name) int name (const void *input, size_t size, WorkPoolOutput *output, void *worker)
+typedef WORK_POOL_PROCESS_FUNCTION(WorkPoolProcessFunction);
+
+#define WORK_POOL_WRITE_FUNCTION(name) int name (const void *bytes, size_t count, void *data)
+typedef WORK_POOL_WRITE_FUNCTION(WorkPoolWriteFunction);
+
+typedef struct {
+  const char *name;
+
+  unsigned int workerCount;
+  void *const *workerData; /* one for each worker */
+  WorkPoolProcessFunction *process;
+
+  WorkPoolWriteFunction *write;
+  void *writeData;
+} WorkPoolParameters;
+
+extern WorkPool *newWorkPool (const WorkPoolParameters *parameters);
+extern void destroyWorkPool (WorkPool *pool);
+
+extern int submitWorkPoolInput (WorkPool *pool, const void *input, size_t size);
+extern int finishWorkPool (WorkPool *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_WORKPOOL */
@@ -23,6 +23,7 @@
 #include "file.h"
 #include "datafile.h"
 #include "dataarea.h"
+#include "memusage.h"
 #include "atb.h"
 #include "atb_internal.h"
 
@@ -179,8 +180,10 @@ compileAttributesTable (const char *name) {
         if (processDataFile(name, &parameters)) {
           if (makeAttributesToDots(&atd)) {
             if ((table = malloc(sizeof(*table)))) {
+              shrinkDataArea(atd.area);
               table->header.fields = getAttributesTableHeader(&atd);
               table->size = getDataSize(atd.area);
+              addMemoryUsage(MEMORY_TABLES, table->size);
               resetDataArea(atd.area);
             }
           }
@@ -197,6 +200,7 @@ compileAttributesTable (const char *name) {
 void
 destroyAttributesTable (AttributesTable *table) {
   if (table->size) {
+    subtractMemoryUsage(MEMORY_TABLES, table->size);
     free(table->header.fields);
     free(table);
   }
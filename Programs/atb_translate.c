@@ -56,8 +56,8 @@ convertAttributesToDots (AttributesTable *table, unsigned char attributes) {
   return table->header.fields->attributesToDots[attributes];
 }
 
-int
-replaceAttributesTable (const char *directory, const char *name) {
+AttributesTable *
+compileNamedAttributesTable (const char *directory, const char *name) {
   AttributesTable *newTable = NULL;
 
   if (*name) {
@@ -76,14 +76,26 @@ replaceAttributesTable (const char *directory, const char *name) {
     newTable = &internalAttributesTable;
   }
 
-  if (newTable) {
-    AttributesTable *oldTable = attributesTable;
+  return newTable;
+}
+
+void
+installAttributesTable (AttributesTable *newTable) {
+  AttributesTable *oldTable = attributesTable;
 
-    lockAttributesTable();
-      attributesTable = newTable;
-    unlockAttributesTable();
+  lockAttributesTable();
+    attributesTable = newTable;
+  unlockAttributesTable();
 
-    destroyAttributesTable(oldTable);
+  destroyAttributesTable(oldTable);
+}
+
+int
+replaceAttributesTable (const char *directory, const char *name) {
+  AttributesTable *newTable = compileNamedAttributesTable(directory, name);
+
+  if (newTable) {
+    installAttributesTable(newTable);
     return 1;
   }
 
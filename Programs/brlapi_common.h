@@ -828,6 +828,13 @@ static const brlapi_param_properties_t brlapi_param_properties[BRLAPI_PARAM_COUN
     .canWatch = 1,
     .canWrite = 1,
   },
+
+//Diagnostic Parameters
+  [BRLAPI_PARAM_MEMORY_USAGE] = {
+    .type = BRLAPI_PARAM_TYPE_UINT64,
+    .canRead = 1,
+    .isArray = 1,
+  },
 };
 
 const brlapi_param_properties_t *brlapi_getParameterProperties(brlapi_param_t parameter) {
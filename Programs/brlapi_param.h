@@ -100,7 +100,12 @@ typedef enum {
 
  /* TODO: help strings */
 
-  BRLAPI_PARAM_COUNT = 32 /** Number of parameters */
+//Diagnostic Parameters
+  BRLAPI_PARAM_MEMORY_USAGE = 32,		/**< Bytes of memory used by each server component:
+						  * uint64_t[], one component per element
+						  * (see brlapi_param_memoryComponent_t) */
+
+  BRLAPI_PARAM_COUNT = 33 /** Number of parameters */
 } brlapi_param_t;
 
 /* brlapi_param_subparam_t */
@@ -254,6 +259,21 @@ typedef char *brlapi_param_literaryBrailleTable_t;
 /** Type to be used for BRLAPI_PARAM_MESSAGE_LOCALE      */
 typedef char *brlapi_param_messageLocale_t;
 
+/* brlapi_param_memoryUsage_t */
+/** Type to be used for BRLAPI_PARAM_MEMORY_USAGE */
+typedef uint64_t *brlapi_param_memoryUsage_t;
+
+/* brlapi_param_memoryComponent_t */
+/** Element indices for BRLAPI_PARAM_MEMORY_USAGE */
+typedef enum {
+  BRLAPI_PARAM_MEMORY_TABLES = 0,		/**< Text, contraction, attributes, and key tables */
+  BRLAPI_PARAM_MEMORY_SCREEN_CACHES = 1,	/**< Screen content caches */
+  BRLAPI_PARAM_MEMORY_API_CONNECTIONS = 2,	/**< BrlAPI client connections */
+  BRLAPI_PARAM_MEMORY_QUEUES = 3,		/**< Queues and their elements */
+  BRLAPI_PARAM_MEMORY_LOG_HISTORY = 4,		/**< Log message history */
+  BRLAPI_PARAM_MEMORY_CLIPBOARD = 5,		/**< Clipboard content and history */
+} brlapi_param_memoryComponent_t;
+
 /** Deprecated in BRLTTY-6.2 - use BRLAPI_PARAM_BOUND_COMMAND_KEYCODES */
 #define BRLAPI_PARAM_BOUND_COMMAND_CODES BRLAPI_PARAM_BOUND_COMMAND_KEYCODES
 /** Deprecated in BRLTTY-6.2 - use brlapi_param_commandKeycode_t */
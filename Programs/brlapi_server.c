@@ -107,6 +107,8 @@ Samuel Thibault <samuel.thibault@ens-lyon.org>"
 #include "async_signal.h"
 #include "thread.h"
 #include "blink.h"
+#include "startup.h"
+#include "memusage.h"
 
 #ifdef __MINGW32__
 #define LogSocketError(msg) logWindowsSocketError(msg)
@@ -671,6 +673,7 @@ static Connection *createConnection(FileDescriptor fd, time_t currentTime)
     goto outmalloc;
   c->subscriptions.next = &c->subscriptions;
   c->subscriptions.prev = &c->subscriptions;
+  addMemoryUsage(MEMORY_API_CONNECTIONS, sizeof(*c));
   return c;
 
 outmalloc:
@@ -713,6 +716,7 @@ static void freeConnection(Connection *c)
 
   freeBrailleWindow(&c->brailleWindow);
   freeKeyrangeList(&c->acceptedKeys);
+  subtractMemoryUsage(MEMORY_API_CONNECTIONS, sizeof(*c));
   free(c);
 }
 
@@ -1790,12 +1794,20 @@ PARAM_WRITER(audibleAlerts)
 /* BRLAPI_PARAM_CLIPBOARD_CONTENT */
 PARAM_READER(clipboardContent)
 {
-  char *content = getMainClipboardContent();
-  if (!content) return "no memory";
+  ClipboardObject *cpb = getMainClipboard();
+  const char *problem = NULL;
 
-  param_readString(content, data, size);
-  free(content);
-  return NULL;
+  lockMainClipboard();
+    const char *content = getClipboardContentText(cpb);
+
+    if (content) {
+      param_readString(content, data, size);
+    } else {
+      problem = "no memory";
+    }
+  unlockMainClipboard();
+
+  return problem;
 }
 
 PARAM_WRITER(clipboardContent)
@@ -2033,6 +2045,30 @@ PARAM_WRITER(messageLocale)
   return param_writeString(changeMessageLocale, data, size);
 }
 
+/* BRLAPI_PARAM_MEMORY_USAGE */
+PARAM_READER(memoryUsage)
+{
+  static const MemoryComponent components[] = {
+    [BRLAPI_PARAM_MEMORY_TABLES] = MEMORY_TABLES,
+    [BRLAPI_PARAM_MEMORY_SCREEN_CACHES] = MEMORY_SCREEN_CACHES,
+    [BRLAPI_PARAM_MEMORY_API_CONNECTIONS] = MEMORY_API_CONNECTIONS,
+    [BRLAPI_PARAM_MEMORY_QUEUES] = MEMORY_QUEUES,
+    [BRLAPI_PARAM_MEMORY_LOG_HISTORY] = MEMORY_LOG_HISTORY,
+    [BRLAPI_PARAM_MEMORY_CLIPBOARD] = MEMORY_CLIPBOARD,
+  };
+
+  uint64_t *memoryUsage = data;
+  unsigned int count = ARRAY_COUNT(components);
+  *size = count * sizeof(*memoryUsage);
+
+  for (unsigned int index=0; index<count; index+=1) {
+    memoryUsage[index] = getMemoryUsage(components[index]);
+  }
+
+  logMemoryUsage("api request");
+  return NULL;
+}
+
 typedef struct {
   unsigned local:1;
   unsigned global:1;
@@ -2228,6 +2264,12 @@ static const ParamDispatch paramDispatch[BRLAPI_PARAM_COUNT] = {
     .read = param_messageLocale_read,
     .write = param_messageLocale_write,
   },
+
+//Diagnostic Parameters
+  [BRLAPI_PARAM_MEMORY_USAGE] = {
+    .global = 1,
+    .read = param_memoryUsage_read,
+  },
 };
 
 static inline const ParamDispatch *param_getDispatch(brlapi_param_t parameter)
@@ -3579,7 +3621,9 @@ THREAD_FUNCTION(createServerSocket) {
   logMessage(LOG_CATEGORY(SERVER_EVENTS), "socket creation started: %"PRIdPTR, num);
 
   if (prepareThread()) {
+    beginStartupPhase("server socket creation");
     createSocket(num);
+    endStartupPhase();
   }
 
   lockMutex(&apiSocketsMutex);
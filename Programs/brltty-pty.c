@@ -48,6 +48,8 @@ static char *opt_asGroup;
 static char *opt_workingDirectory;
 static char *opt_homeDirectory;
 
+static char *opt_updateInterval;
+
 static int opt_logInput;
 static int opt_logOutput;
 static int opt_logSequences;
@@ -94,6 +96,13 @@ BEGIN_OPTION_TABLE(programOptions)
     .description = strtext("the home directory to use")
   },
 
+  { .word = "update-interval",
+    .letter = 'i',
+    .argument = strtext("milliseconds"),
+    .setting.string = &opt_updateInterval,
+    .description = strtext("the minimum time between screen update notifications")
+  },
+
   { .word = "log-input",
     .letter = 'I',
     .flags = OPT_Hidden,
@@ -349,7 +358,7 @@ runParent (PtyObject *pty, pid_t child) {
   childHasTerminated = 0;
   slaveHasBeenClosed = 0;
 
-  if (asyncReadFile(&ptyInputHandle, ptyGetMaster(pty), 1, ptyInputHandler, NULL)) {
+  if (asyncReadFile(&ptyInputHandle, ptyGetMaster(pty), 0X1000, ptyInputHandler, NULL)) {
     AsyncHandle standardInputHandle;
 
     if (asyncMonitorFileInput(&standardInputHandle, STDIN_FILENO, standardInputMonitor, pty)) {
@@ -399,6 +408,18 @@ main (int argc, char *argv[]) {
   ptySetLogTerminalSequences(opt_logSequences);
   ptySetLogUnexpectedTerminalIO(opt_logUnexpected);
 
+  {
+    int interval = 0;
+    static const int minimum = 0;
+
+    if (!validateInteger(&interval, opt_updateInterval, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid update interval: %s", opt_updateInterval);
+      return PROG_EXIT_SYNTAX;
+    }
+
+    ptySetTerminalUpdateInterval(interval);
+  }
+
   if (!isatty(STDIN_FILENO)) {
     logMessage(LOG_ERR, "%s", gettext("standard input isn't a terminal"));
     return PROG_EXIT_SEMANTIC;
@@ -20,22 +20,26 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <errno.h>
 
 #include "program.h"
 #include "options.h"
 #include "log.h"
 #include "file.h"
+#include "parse.h"
 #include "unicode.h"
 #include "utf8.h"
 #include "brl_dots.h"
 #include "ttb.h"
+#include "workpool.h"
 
 static char *opt_tablesDirectory;
 static char *opt_inputTable;
 static char *opt_outputTable;
 static int opt_sixDots;
 static int opt_noBaseCharacters;
+static char *opt_jobs;
 
 static const char tableName_autoselect[] = "auto";
 static const char tableName_unicode[] = "unicode";
@@ -78,6 +82,14 @@ BEGIN_OPTION_TABLE(programOptions)
     .setting.flag = &opt_noBaseCharacters,
     .description = strtext("Don't fall back to the Unicode base character.")
   },
+
+  { .word = "jobs",
+    .letter = 'j',
+    .argument = strtext("count"),
+    .setting.string = &opt_jobs,
+    .internal.setting = "",
+    .description = strtext("Number of threads to translate with.")
+  },
 END_OPTION_TABLE
 
 static TextTable *inputTable;
@@ -85,6 +97,7 @@ static TextTable *outputTable;
 
 static FILE *outputStream;
 static const char *outputName;
+static int jobCount;
 
 static unsigned char (*toDots) (wchar_t character);
 static wchar_t (*toCharacter) (unsigned char dots);
@@ -112,17 +125,68 @@ toCharacter_unicode (unsigned char dots) {
 }
 
 static int
-writeCharacter (const wchar_t *character, mbstate_t *state) {
+writeCharacter (const wchar_t *character, mbstate_t *state, WorkPoolOutput *output) {
   char bytes[0X1000];
   size_t result = wcrtomb(bytes, (character? *character: WC_C('\0')), state);
 
   if (result == (size_t)-1) return 0;
   if (!character) result -= 1;
 
+  if (output) return appendWorkPoolOutput(output, bytes, result);
   fwrite(bytes, 1, result, outputStream);
   return !ferror(outputStream);
 }
 
+typedef enum {
+  TRANSLATION_DONE,
+  TRANSLATION_INPUT_ERROR,
+  TRANSLATION_OUTPUT_ERROR
+} TranslationResult;
+
+static TranslationResult
+translateBytes (
+  const char *byte, size_t count,
+  mbstate_t *inputState, mbstate_t *outputState,
+  WorkPoolOutput *output
+) {
+  while (count) {
+    wchar_t character;
+
+    {
+      size_t result = mbrtowc(&character, byte, count, inputState);
+
+      if (result == (size_t)-2) break;
+      if (result == (size_t)-1) return TRANSLATION_INPUT_ERROR;
+      if (!result) result = 1;
+
+      byte += result;
+      count -= result;
+    }
+
+    if (!iswcntrl(character)) {
+      unsigned char dots = toDots(character);
+
+      if (dots || !iswspace(character)) {
+        if (opt_sixDots) dots &= ~(BRL_DOT_7 | BRL_DOT_8);
+        character = toCharacter(dots);
+      }
+    }
+
+    if (!writeCharacter(&character, outputState, output)) return TRANSLATION_OUTPUT_ERROR;
+  }
+
+  return TRANSLATION_DONE;
+}
+
+static void
+setIncompleteCharacterError (void) {
+#ifdef EILSEQ
+  errno = EILSEQ;
+#else /* EILSEQ */
+  errno = EINVAL;
+#endif /* EILSEQ */
+}
+
 static int
 processStream (FILE *inputStream, const char *inputName) {
   mbstate_t inputState;
@@ -139,47 +203,24 @@ processStream (FILE *inputStream, const char *inputName) {
     if (!inputCount) break;
     inputBuffer[inputCount] = 0;
 
-    {
-      char *byte = inputBuffer;
-
-      while (inputCount) {
-        wchar_t character;
-
-        {
-          size_t result = mbrtowc(&character, byte, inputCount, &inputState);
+    switch (translateBytes(inputBuffer, inputCount, &inputState, &outputState, NULL)) {
+      case TRANSLATION_INPUT_ERROR:
+        goto inputError;
 
-          if (result == (size_t)-2) break;
-          if (result == (size_t)-1) goto inputError;
-          if (!result) result = 1;
-
-          byte += result;
-          inputCount -= result;
-        }
+      case TRANSLATION_OUTPUT_ERROR:
+        goto outputError;
 
-        if (!iswcntrl(character)) {
-          unsigned char dots = toDots(character);
-
-          if (dots || !iswspace(character)) {
-            if (opt_sixDots) dots &= ~(BRL_DOT_7 | BRL_DOT_8);
-            character = toCharacter(dots);
-          }
-        }
-
-        if (!writeCharacter(&character, &outputState)) goto outputError;
-      }
+      default:
+        break;
     }
   }
 
-  if (!writeCharacter(NULL, &outputState)) goto outputError;
+  if (!writeCharacter(NULL, &outputState, NULL)) goto outputError;
   fflush(outputStream);
   if (ferror(outputStream)) goto outputError;
 
   if (!mbsinit(&inputState)) {
-#ifdef EILSEQ
-    errno = EILSEQ;
-#else /* EILSEQ */
-    errno = EINVAL;
-#endif /* EILSEQ */
+    setIncompleteCharacterError();
     goto inputError;
   }
 
@@ -194,6 +235,133 @@ outputError:
   return 0;
 }
 
+/* The input is split, at line boundaries, into chunks which are translated
+ * by a pool of worker threads, and the output of each chunk is written in
+ * the order in which it was read. A chunk ends at a line boundary so that
+ * it can be decoded from the initial shift state.
+ */
+#define CHUNK_SIZE 0X10000
+
+typedef struct {
+  const char *inputName;
+  char bytes[];
+} TranslationChunk;
+
+static WorkPool *workPool;
+static TranslationChunk *chunkBuffer;
+static size_t chunkSize;
+static size_t chunkLength;
+
+static
+WORK_POOL_PROCESS_FUNCTION(translateChunk) {
+  const TranslationChunk *chunk = input;
+  size_t count = size - offsetof(TranslationChunk, bytes);
+
+  mbstate_t inputState;
+  memset(&inputState, 0, sizeof(inputState));
+
+  mbstate_t outputState;
+  memset(&outputState, 0, sizeof(outputState));
+
+  switch (translateBytes(chunk->bytes, count, &inputState, &outputState, output)) {
+    case TRANSLATION_INPUT_ERROR:
+      goto inputError;
+
+    case TRANSLATION_OUTPUT_ERROR:
+      return 0;
+
+    default:
+      break;
+  }
+
+  if (!writeCharacter(NULL, &outputState, output)) return 0;
+
+  if (!mbsinit(&inputState)) {
+    setIncompleteCharacterError();
+    goto inputError;
+  }
+
+  return 1;
+
+inputError:
+  logMessage(LOG_ERR, "input error: %s: %s", chunk->inputName, strerror(errno));
+  return 0;
+}
+
+static
+WORK_POOL_WRITE_FUNCTION(writeChunk) {
+  fwrite(bytes, 1, count, outputStream);
+
+  if (ferror(outputStream)) {
+    logMessage(LOG_ERR, "output error: %s: %s", outputName, strerror(errno));
+    return 0;
+  }
+
+  return 1;
+}
+
+static int
+submitChunk (size_t count) {
+  if (!submitWorkPoolInput(workPool, chunkBuffer, (offsetof(TranslationChunk, bytes) + count))) return 0;
+
+  chunkLength -= count;
+  memmove(chunkBuffer->bytes, &chunkBuffer->bytes[count], chunkLength);
+  return 1;
+}
+
+static int
+processStreamInParallel (FILE *inputStream, const char *inputName) {
+  chunkLength = 0;
+
+  while (!feof(inputStream)) {
+    if ((chunkSize - chunkLength) < CHUNK_SIZE) {
+      size_t newSize = chunkLength + CHUNK_SIZE;
+      TranslationChunk *newBuffer = realloc(chunkBuffer, (offsetof(TranslationChunk, bytes) + newSize));
+
+      if (!newBuffer) {
+        logMallocError();
+        return 0;
+      }
+
+      chunkBuffer = newBuffer;
+      chunkSize = newSize;
+    }
+
+    chunkBuffer->inputName = inputName;
+
+    {
+      size_t inputCount = fread(&chunkBuffer->bytes[chunkLength], 1, (chunkSize - chunkLength), inputStream);
+
+      if (ferror(inputStream)) goto inputError;
+      if (!inputCount) break;
+      chunkLength += inputCount;
+    }
+
+    if (chunkLength >= CHUNK_SIZE) {
+      size_t count = chunkLength;
+
+      while (count) {
+        if (chunkBuffer->bytes[count-1] == '\n') break;
+        count -= 1;
+      }
+
+      if (count)
+        if (!submitChunk(count))
+          return 0;
+    }
+  }
+
+  if (chunkLength)
+    if (!submitChunk(chunkLength))
+      return 0;
+
+  return 1;
+
+inputError:
+  logMessage(LOG_ERR, "input error: %s: %s", inputName, strerror(errno));
+  return 0;
+}
+
 static int
 getTable (TextTable **table, const char *name) {
   const char *directory = opt_tablesDirectory;
@@ -240,6 +408,17 @@ main (int argc, char *argv[]) {
     PROCESS_OPTIONS(descriptor, argc, argv);
   }
 
+  if (!*opt_jobs) {
+    jobCount = 0;
+  } else {
+    static const int minimum = 1;
+
+    if (!validateInteger(&jobCount, opt_jobs, &minimum, NULL)) {
+      logMessage(LOG_ERR, "%s: %s", "invalid job count", opt_jobs);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
   if (getTable(&inputTable, opt_inputTable)) {
     if (getTable(&outputTable, opt_outputTable)) {
       outputStream = stdout;
@@ -248,15 +427,39 @@ main (int argc, char *argv[]) {
       toDots = inputTable? toDots_mapped: toDots_unicode;
       toCharacter = outputTable? toCharacter_mapped: toCharacter_unicode;
 
-      if (argc) {
+      int (*processInputStream) (FILE *inputStream, const char *inputName) = processStream;
+      workPool = NULL;
+
+      if (jobCount) {
+        const WorkPoolParameters parameters = {
+          .name = "translate",
+          .workerCount = jobCount,
+          .process = translateChunk,
+          .write = writeChunk
+        };
+
+        chunkBuffer = NULL;
+        chunkSize = 0;
+        chunkLength = 0;
+
+        if ((workPool = newWorkPool(&parameters))) {
+          processInputStream = processStreamInParallel;
+        } else {
+          processInputStream = NULL;
+        }
+      }
+
+      if (!processInputStream) {
+        exitStatus = PROG_EXIT_FATAL;
+      } else if (argc) {
         do {
           const char *file = argv[0];
           FILE *stream;
 
           if (strcmp(file, standardStreamArgument) == 0) {
-            if (!processStream(stdin, standardInputName)) break;
+            if (!processInputStream(stdin, standardInputName)) break;
           } else if ((stream = fopen(file, "r"))) {
-            int ok = processStream(stream, file);
+            int ok = processInputStream(stream, file);
             fclose(stream);
             if (!ok) break;
           } else {
@@ -269,10 +472,31 @@ main (int argc, char *argv[]) {
         } while (argc);
 
         if (!argc) exitStatus = PROG_EXIT_SUCCESS;
-      } else if (processStream(stdin, standardInputName)) {
+      } else if (processInputStream(stdin, standardInputName)) {
         exitStatus = PROG_EXIT_SUCCESS;
       }
 
+      if (workPool) {
+        if (!finishWorkPool(workPool)) {
+          if (exitStatus == PROG_EXIT_SUCCESS) exitStatus = PROG_EXIT_FATAL;
+        } else {
+          fflush(outputStream);
+
+          if (ferror(outputStream)) {
+            logMessage(LOG_ERR, "output error: %s: %s", outputName, strerror(errno));
+            exitStatus = PROG_EXIT_FATAL;
+          }
+        }
+
+        destroyWorkPool(workPool);
+        workPool = NULL;
+
+        if (chunkBuffer) {
+          free(chunkBuffer);
+          chunkBuffer = NULL;
+        }
+      }
+
       if (outputTable) destroyTextTable(outputTable);
     }
 
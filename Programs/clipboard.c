@@ -24,14 +24,26 @@
 #include "log.h"
 #include "clipboard.h"
 #include "utf8.h"
-#include "queue.h"
 #include "lock.h"
 #include "program.h"
+#include "memusage.h"
+#include "parameters.h"
 #include "api_control.h"
 
+/* The history is kept in one arena of characters which is never allowed to
+ * grow beyond a fixed size, with the oldest entries being discarded to make
+ * room for new ones. The entries are described by a ring, newest first, so
+ * that any of them can be found by its index. Each entry has a hash of its
+ * content so that content which is already in the history is moved to the top
+ * rather than being stored again.
+ */
+
+typedef uint32_t HistoryHash;
+
 typedef struct {
-  wchar_t *characters;
+  size_t offset;
   size_t length;
+  HistoryHash hash;
 } HistoryEntry;
 
 struct ClipboardObjectStruct {
@@ -42,61 +54,220 @@ struct ClipboardObjectStruct {
   } buffer;
 
   struct {
-    Queue *queue;
+    char *text;
+    size_t size;
+  } utf8;
+
+  struct {
+    wchar_t *arena;
+    size_t size;
+    size_t used;
+    size_t live;
+
+    HistoryEntry entries[CLIPBOARD_HISTORY_MAXIMUM_ENTRIES];
+    unsigned int first;
+    unsigned int count;
   } history;
+
+  size_t memoryUsage;
 };
 
+static void
+updateClipboardMemoryUsage (ClipboardObject *cpb) {
+  updateMemoryUsage(
+    MEMORY_CLIPBOARD, &cpb->memoryUsage,
+    (sizeof(*cpb) +
+     ARRAY_SIZE(cpb->buffer.characters, cpb->buffer.size) +
+     cpb->utf8.size +
+     ARRAY_SIZE(cpb->history.arena, cpb->history.size))
+  );
+}
+
+static HistoryHash
+hashHistoryContent (const wchar_t *characters, size_t length) {
+  HistoryHash hash = UINT32_C(0X811C9DC5);
+
+  while (length > 0) {
+    hash ^= (uint32_t)*characters++;
+    hash *= UINT32_C(0X01000193);
+    length -= 1;
+  }
+
+  return hash;
+}
+
+static inline HistoryEntry *
+getHistoryEntry (ClipboardObject *cpb, unsigned int index) {
+  return &cpb->history.entries[(cpb->history.first + index) % CLIPBOARD_HISTORY_MAXIMUM_ENTRIES];
+}
+
+static inline const wchar_t *
+getHistoryCharacters (ClipboardObject *cpb, const HistoryEntry *entry) {
+  return &cpb->history.arena[entry->offset];
+}
+
 const wchar_t *
 getClipboardHistory (ClipboardObject *cpb, unsigned int index, size_t *length) {
-  Element *element = getStackElement(cpb->history.queue, index);
-  if (!element) return NULL;
+  if (index >= cpb->history.count) return NULL;
 
-  const HistoryEntry *entry = getElementItem(element);
+  const HistoryEntry *entry = getHistoryEntry(cpb, index);
   *length = entry->length;
-  return entry->characters;
+  return getHistoryCharacters(cpb, entry);
 }
 
-int
-addClipboardHistory (ClipboardObject *cpb, const wchar_t *characters, size_t length) {
-  if (!length) return 1;
+static int
+findHistoryEntry (ClipboardObject *cpb, const wchar_t *characters, size_t length, HistoryHash hash) {
+  for (unsigned int index=0; index<cpb->history.count; index+=1) {
+    const HistoryEntry *entry = getHistoryEntry(cpb, index);
 
-  Queue *queue = cpb->history.queue;
-  Element *element = getStackHead(queue);
+    if (entry->hash != hash) continue;
+    if (entry->length != length) continue;
+    if (wmemcmp(getHistoryCharacters(cpb, entry), characters, length) != 0) continue;
+    return index;
+  }
 
-  if (element) {
-    const HistoryEntry *entry = getElementItem(element);
+  return -1;
+}
 
-    if (length == entry->length) {
-      if (wmemcmp(characters, entry->characters, length) == 0) {
-        return 1;
-      }
+static void
+moveHistoryEntryToTop (ClipboardObject *cpb, unsigned int index) {
+  HistoryEntry entry = *getHistoryEntry(cpb, index);
+
+  while (index > 0) {
+    *getHistoryEntry(cpb, index) = *getHistoryEntry(cpb, index-1);
+    index -= 1;
+  }
+
+  *getHistoryEntry(cpb, 0) = entry;
+}
+
+static void
+discardOldestHistoryEntry (ClipboardObject *cpb) {
+  cpb->history.count -= 1;
+  cpb->history.live -= getHistoryEntry(cpb, cpb->history.count)->length;
+}
+
+static int
+compareHistoryOffsets (const void *element1, const void *element2) {
+  const HistoryEntry *const *entry1 = element1;
+  const HistoryEntry *const *entry2 = element2;
+
+  if ((*entry1)->offset < (*entry2)->offset) return -1;
+  if ((*entry1)->offset > (*entry2)->offset) return 1;
+  return 0;
+}
+
+static void
+compactHistoryArena (ClipboardObject *cpb) {
+  unsigned int count = cpb->history.count;
+
+  if (!count) {
+    cpb->history.used = 0;
+    return;
+  }
+
+  HistoryEntry *entries[count];
+
+  for (unsigned int index=0; index<count; index+=1) {
+    entries[index] = getHistoryEntry(cpb, index);
+  }
+
+  /* moving them down in the order they're in means nothing is overwritten */
+  qsort(entries, count, sizeof(*entries), compareHistoryOffsets);
+  size_t offset = 0;
+
+  for (unsigned int index=0; index<count; index+=1) {
+    HistoryEntry *entry = entries[index];
+
+    if (entry->offset != offset) {
+      wmemmove(&cpb->history.arena[offset], getHistoryCharacters(cpb, entry), entry->length);
+      entry->offset = offset;
     }
+
+    offset += entry->length;
   }
 
-  {
-    HistoryEntry *entry;
+  cpb->history.used = offset;
+}
 
-    if ((entry = malloc(sizeof(*entry)))) {
-      if ((entry->characters = allocateCharacters(length))) {
-        wmemcpy(entry->characters, characters, length);
-        entry->length = length;
+static int
+reserveHistorySpace (ClipboardObject *cpb, size_t length) {
+  while ((cpb->history.count == CLIPBOARD_HISTORY_MAXIMUM_ENTRIES) ||
+         ((cpb->history.live + length) > CLIPBOARD_HISTORY_MAXIMUM_SIZE)) {
+    discardOldestHistoryEntry(cpb);
+  }
 
-        if (enqueueItem(queue, entry)) {
-          return 1;
-        }
+  if ((cpb->history.used + length) > cpb->history.size) {
+    if (cpb->history.used > cpb->history.live) compactHistoryArena(cpb);
+  }
 
-        free(entry->characters);
-      } else {
-        logMallocError();
-      }
+  if ((cpb->history.used + length) > cpb->history.size) {
+    size_t newSize = cpb->history.size? (cpb->history.size << 1): 0X400;
+    while (newSize < (cpb->history.used + length)) newSize <<= 1;
+    if (newSize > CLIPBOARD_HISTORY_MAXIMUM_SIZE) newSize = CLIPBOARD_HISTORY_MAXIMUM_SIZE;
 
-      free(entry);
-    } else {
+    wchar_t *newArena = realloc(cpb->history.arena, ARRAY_SIZE(newArena, newSize));
+
+    if (!newArena) {
       logMallocError();
+      return 0;
     }
+
+    cpb->history.arena = newArena;
+    cpb->history.size = newSize;
+    updateClipboardMemoryUsage(cpb);
   }
 
-  return 0;
+  return 1;
+}
+
+int
+addClipboardHistory (ClipboardObject *cpb, const wchar_t *characters, size_t length) {
+  if (!length) return 1;
+  HistoryHash hash = hashHistoryContent(characters, length);
+
+  {
+    int index = findHistoryEntry(cpb, characters, length, hash);
+
+    if (index >= 0) {
+      moveHistoryEntryToTop(cpb, index);
+      return 1;
+    }
+  }
+
+  if (length > CLIPBOARD_HISTORY_MAXIMUM_SIZE) {
+    logMessage(LOG_WARNING, "clipboard content too large for history: %"PRIsize, length);
+    return 1;
+  }
+
+  if (!reserveHistorySpace(cpb, length)) return 0;
+
+  {
+    cpb->history.first += CLIPBOARD_HISTORY_MAXIMUM_ENTRIES - 1;
+    cpb->history.first %= CLIPBOARD_HISTORY_MAXIMUM_ENTRIES;
+    cpb->history.count += 1;
+
+    HistoryEntry *entry = getHistoryEntry(cpb, 0);
+    entry->offset = cpb->history.used;
+    entry->length = length;
+    entry->hash = hash;
+
+    wmemcpy(&cpb->history.arena[entry->offset], characters, length);
+    cpb->history.used += length;
+    cpb->history.live += length;
+  }
+
+  return 1;
+}
+
+static void
+invalidateClipboardContentUTF8 (ClipboardObject *cpb) {
+  if (cpb->utf8.text) {
+    free(cpb->utf8.text);
+    cpb->utf8.text = NULL;
+    cpb->utf8.size = 0;
+    updateClipboardMemoryUsage(cpb);
+  }
 }
 
 const wchar_t *
@@ -105,11 +276,34 @@ getClipboardContent (ClipboardObject *cpb, size_t *length) {
   return cpb->buffer.characters;
 }
 
+const char *
+getClipboardContentText (ClipboardObject *cpb) {
+  if (!cpb->utf8.text) {
+    size_t length;
+    const wchar_t *characters = getClipboardContent(cpb, &length);
+
+    if (!(cpb->utf8.text = getUtf8FromWchars(characters, length, NULL))) return NULL;
+    cpb->utf8.size = strlen(cpb->utf8.text) + 1;
+    updateClipboardMemoryUsage(cpb);
+  }
+
+  return cpb->utf8.text;
+}
+
 char *
 getClipboardContentUTF8 (ClipboardObject *cpb) {
-  size_t length;
-  const wchar_t *characters = getClipboardContent(cpb, &length);
-  return getUtf8FromWchars(characters, length, NULL);
+  const char *text = getClipboardContentText(cpb);
+  if (!text) return NULL;
+
+  char *copy = malloc(cpb->utf8.size);
+
+  if (!copy) {
+    logMallocError();
+    return NULL;
+  }
+
+  memcpy(copy, text, cpb->utf8.size);
+  return copy;
 }
 
 size_t
@@ -121,6 +315,7 @@ int
 truncateClipboardContent (ClipboardObject *cpb, size_t length) {
   if (length >= cpb->buffer.length) return 0;
   cpb->buffer.length = length;
+  invalidateClipboardContentUTF8(cpb);
   return 1;
 }
 
@@ -139,22 +334,23 @@ appendClipboardContent (ClipboardObject *cpb, const wchar_t *characters, size_t
   size_t newLength = cpb->buffer.length + length;
 
   if (newLength > cpb->buffer.size) {
-    size_t newSize = newLength | 0XFF;
-    wchar_t *newCharacters = allocateCharacters(newSize);
+    size_t newSize = (cpb->buffer.size << 1) | 0XFF;
+    if (newSize < newLength) newSize = newLength | 0XFF;
+    wchar_t *newCharacters = realloc(cpb->buffer.characters, ARRAY_SIZE(newCharacters, newSize));
 
     if (!newCharacters) {
       logMallocError();
       return 0;
     }
 
-    wmemcpy(newCharacters, cpb->buffer.characters, cpb->buffer.length);
-    if (cpb->buffer.characters) free(cpb->buffer.characters);
     cpb->buffer.characters = newCharacters;
     cpb->buffer.size = newSize;
+    updateClipboardMemoryUsage(cpb);
   }
 
   wmemcpy(&cpb->buffer.characters[cpb->buffer.length], characters, length);
   cpb->buffer.length += length;
+  if (length) invalidateClipboardContentUTF8(cpb);
   return 1;
 }
 
@@ -180,13 +376,6 @@ setClipboardContentUTF8 (ClipboardObject *cpb, const char *text) {
   return truncated || appended;
 }
 
-static void
-deallocateClipboardHistoryEntry (void *item, void *data) {
-  HistoryEntry *entry = item;
-  if (entry->characters) free(entry->characters);
-  free(entry);
-}
-
 ClipboardObject *
 newClipboard (void) {
   ClipboardObject *cpb;
@@ -198,9 +387,19 @@ newClipboard (void) {
     cpb->buffer.size = 0;
     cpb->buffer.length = 0;
 
-    if ((cpb->history.queue = newQueue(deallocateClipboardHistoryEntry, NULL))) {
-      return cpb;
-    }
+    cpb->utf8.text = NULL;
+    cpb->utf8.size = 0;
+
+    cpb->history.arena = NULL;
+    cpb->history.size = 0;
+    cpb->history.used = 0;
+    cpb->history.live = 0;
+    cpb->history.first = 0;
+    cpb->history.count = 0;
+
+    cpb->memoryUsage = 0;
+    updateClipboardMemoryUsage(cpb);
+    return cpb;
   } else {
     logMallocError();
   }
@@ -211,7 +410,9 @@ newClipboard (void) {
 void
 destroyClipboard (ClipboardObject *cpb) {
   if (cpb->buffer.characters) free(cpb->buffer.characters);
-  deallocateQueue(cpb->history.queue);
+  if (cpb->utf8.text) free(cpb->utf8.text);
+  if (cpb->history.arena) free(cpb->history.arena);
+  updateMemoryUsage(MEMORY_CLIPBOARD, &cpb->memoryUsage, 0);
   free(cpb);
 }
 
@@ -30,6 +30,7 @@
 #include "clipboard.h"
 #include "brl_cmds.h"
 #include "scr.h"
+#include "scr_index.h"
 #include "routing.h"
 #include "file.h"
 #include "datafile.h"
@@ -413,28 +414,6 @@ cpbRestore (ClipboardCommandData *ccd) {
   return ok;
 }
 
-static int
-findCharacters (const wchar_t **address, size_t *length, const wchar_t *characters, size_t count) {
-  const wchar_t *ptr = *address;
-  size_t len = *length;
-
-  while (count <= len) {
-    const wchar_t *next = wmemchr(ptr, *characters, len);
-    if (!next) break;
-
-    len -= next - ptr;
-    if (wmemcmp((ptr = next), characters, count) == 0) {
-      *address = ptr;
-      *length = len;
-      return 1;
-    }
-
-    ++ptr, --len;
-  }
-
-  return 0;
-}
-
 static int
 handleClipboardCommands (int command, void *data) {
   ClipboardCommandData *ccd = data;
@@ -470,53 +449,16 @@ handleClipboardCommands (int command, void *data) {
       lockMainClipboard();
         if ((cpbBuffer = getClipboardContent(ccd->clipboard, &cpbLength))) {
           int found = 0;
-          size_t count = cpbLength;
-
-          if (count <= scr.cols) {
-            int line = ses->winy;
-            wchar_t buffer[scr.cols];
-            wchar_t characters[count];
-
-            {
-              unsigned int i;
-              for (i=0; i<count; i+=1) characters[i] = towlower(cpbBuffer[i]);
-            }
-
-            while ((line >= 0) && (line <= (int)(scr.rows - brl.textRows))) {
-              const wchar_t *address = buffer;
-              size_t length = scr.cols;
-              readScreenText(0, line, length, 1, buffer);
-
-              {
-                for (size_t i=0; i<length; i+=1) buffer[i] = towlower(buffer[i]);
-              }
 
-              if (line == ses->winy) {
-                if (increment < 0) {
-                  int end = ses->winx + count - 1;
-                  if (end < length) length = end;
-                } else {
-                  int start = ses->winx + textCount;
-                  if (start > length) start = length;
-                  address += start;
-                  length -= start;
-                }
-              }
-
-              if (findCharacters(&address, &length, characters, count)) {
-                if (increment < 0) {
-                  while (findCharacters(&address, &length, characters, count)) {
-                    ++address, --length;
-                  }
-                }
-
-                ses->winy = line;
-                ses->winx = (address - buffer) / textCount * textCount;
-                found = 1;
-                break;
-              }
+          if (cpbLength <= scr.cols) {
+            int column = (increment < 0)? ses->winx: (ses->winx + textCount);
+            int row = ses->winy;
 
-              line += increment;
+            if (findScreenText(cpbBuffer, cpbLength, &column, &row, increment,
+                               (scr.rows - brl.textRows))) {
+              ses->winy = row;
+              ses->winx = column / textCount * textCount;
+              found = 1;
             }
           }
 
@@ -19,6 +19,7 @@
 #include "prologue.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "log.h"
 #include "alert.h"
@@ -33,6 +34,7 @@
 #include "prefs.h"
 #include "routing.h"
 #include "scr.h"
+#include "scr_index.h"
 #include "core.h"
 
 static int
@@ -64,11 +66,11 @@ toDifferentLine (
     unsigned int skipped = 0;
 
     if ((isSameCharacter == isSameText) && ses->displayMode) isSameCharacter = isSameAttributes;
-    readScreen(from, ses->winy, width, 1, characters1);
+    readIndexedScreen(from, ses->winy, width, 1, characters1);
 
     do {
       ScreenCharacter characters2[width];
-      readScreen(from, ses->winy+=amount, width, 1, characters2);
+      readIndexedScreen(from, ses->winy+=amount, width, 1, characters2);
 
       if (!isSameRow(characters1, characters2, width, isSameCharacter) ||
           (showScreenCursor() && (scr.posy == ses->winy) &&
@@ -163,27 +165,82 @@ findRow (int column, int increment, RowTester test, void *data) {
 
 static int
 testIndent (int column, int row, void *data UNUSED) {
-  int count = column+1;
-  ScreenCharacter characters[count];
-  readScreenRow(row, count, characters);
-
-  while (column >= 0) {
-    wchar_t text = characters[column].text;
-    if (text != WC_C(' ')) return 1;
-    column -= 1;
-  }
-
-  return 0;
+  int indent = getScreenRowIndent(row);
+  return (indent >= 0) && (indent <= column);
 }
 
 static RGX_Object *promptPatterns = NULL;
+static unsigned int promptPatternCount = 0;
+
+/* When there's more than one prompt pattern they're also combined into a
+ * single alternation so that each row only needs to be matched once. Each
+ * pattern is within its own branch of a branch reset group so that its
+ * capture groups (and, therefore, its back references) keep their numbers.
+ * If the combination can't be compiled then the patterns are still tried
+ * one at a time.
+ */
+static char *promptAlternatives = NULL;
+static RGX_Object *promptAlternation = NULL;
+static unsigned char promptAlternationFailed = 0;
+
+/* Whether or not a row is a prompt is remembered by the hash of its text so
+ * that rows which haven't changed (even if they've scrolled) needn't be
+ * matched again.
+ */
+typedef struct {
+  uint64_t hash;
+  unsigned char isValid:1;
+  unsigned char isPrompt:1;
+} PromptCacheEntry;
+
+static PromptCacheEntry promptCache[0X100];
+
+static void
+destroyPromptAlternation (void) {
+  if (promptAlternation) {
+    rgxDestroyObject(promptAlternation);
+    promptAlternation = NULL;
+  }
+
+  promptAlternationFailed = 0;
+  memset(promptCache, 0, sizeof(promptCache));
+}
 
 static void
 exitPromptPatterns (void *data) {
+  destroyPromptAlternation();
+
+  if (promptAlternatives) {
+    free(promptAlternatives);
+    promptAlternatives = NULL;
+  }
+
   if (promptPatterns) {
     rgxDestroyObject(promptPatterns);
     promptPatterns = NULL;
   }
+
+  promptPatternCount = 0;
+}
+
+static int
+addPromptAlternative (const char *string) {
+  size_t oldLength = promptAlternatives? strlen(promptAlternatives): 0;
+  size_t size = oldLength + strlen(string) + 6;
+  char *alternatives = realloc(promptAlternatives, size);
+
+  if (!alternatives) {
+    logMallocError();
+    return 0;
+  }
+
+  snprintf(
+    &alternatives[oldLength], (size - oldLength), "%s(?:%s)",
+    (oldLength? "|": ""), string
+  );
+
+  promptAlternatives = alternatives;
+  return 1;
 }
 
 int
@@ -199,16 +256,60 @@ addPromptPattern (const char *string) {
   );
 
   if (!matcher) return 0;
+  promptPatternCount += 1;
+
+  destroyPromptAlternation();
+  if (!addPromptAlternative(string)) promptAlternationFailed = 1;
   return 1;
 }
 
+static RGX_Object *
+getPromptPatterns (void) {
+  if (promptAlternation) return promptAlternation;
+  if (promptAlternationFailed) return promptPatterns;
+  if (promptPatternCount < 2) return promptPatterns;
+
+  if ((promptAlternation = rgxNewObject(NULL))) {
+    rgxCompileOption(promptAlternation, RGX_OPTION_SET, RGX_COMPILE_ANCHOR_START);
+
+    size_t size = strlen(promptAlternatives) + 5;
+    char pattern[size];
+    snprintf(pattern, size, "(?|%s)", promptAlternatives);
+
+    if (rgxAddPatternUTF8(promptAlternation, pattern, NULL, NULL)) {
+      logMessage(LOG_DEBUG, "prompt patterns combined: %u", promptPatternCount);
+      return promptAlternation;
+    }
+
+    rgxDestroyObject(promptAlternation);
+    promptAlternation = NULL;
+  }
+
+  logMessage(LOG_DEBUG, "prompt patterns not combined");
+  promptAlternationFailed = 1;
+  return promptPatterns;
+}
+
+static uint64_t
+hashPromptText (const wchar_t *characters, size_t length) {
+  uint64_t hash = UINT64_C(0XCBF29CE484222325);
+
+  while (length > 0) {
+    hash ^= (uint32_t)*characters++;
+    hash *= UINT64_C(0X100000001B3);
+    length -= 1;
+  }
+
+  return hash;
+}
+
 static int
 testPromptOriginal (int column, int row, void *data) {
   if (!column) return 0;
 
   int length = column + 1;
   ScreenCharacter characters[length];
-  readScreenRow(row, length, characters);
+  readIndexedScreenRow(row, length, characters);
 
   const ScreenCharacter *prompt = data;
   return isSameRow(characters, prompt, length, isSameText);
@@ -221,7 +322,7 @@ testPromptPatterns (int column, int row, void *data) {
 
   {
     ScreenCharacter characters[length];
-    readScreenRow(row, length, characters);
+    readIndexedScreenRow(row, length, characters);
 
     const ScreenCharacter *from = characters;
     const ScreenCharacter *end = from + length;
@@ -230,7 +331,16 @@ testPromptPatterns (int column, int row, void *data) {
     while (from < end) *to++ = from++->text;
   }
 
-  return !!rgxMatchTextCharacters(promptPatterns, text, length, NULL, NULL);
+  uint64_t hash = hashPromptText(text, length);
+  PromptCacheEntry *entry = &promptCache[hash % ARRAY_COUNT(promptCache)];
+  if (entry->isValid && (entry->hash == hash)) return entry->isPrompt;
+
+  int isPrompt = !!rgxMatchTextCharacters(getPromptPatterns(), text, length, NULL, NULL);
+
+  entry->hash = hash;
+  entry->isPrompt = isPrompt;
+  entry->isValid = 1;
+  return isPrompt;
 }
 
 static void
@@ -260,7 +370,7 @@ toPreviousNonblankWindow (void) {
 
     charCount = getWindowLength();
     charCount = MIN(charCount, scr.cols-ses->winx);
-    readScreen(ses->winx, ses->winy, charCount, 1, characters);
+    readIndexedScreen(ses->winx, ses->winy, charCount, 1, characters);
 
     for (charIndex=charCount-1; charIndex>=0; charIndex-=1) {
       wchar_t text = characters[charIndex].text;
@@ -306,7 +416,7 @@ toNextNonblankWindow (void) {
 
     charCount = getWindowLength();
     charCount = MIN(charCount, scr.cols-ses->winx);
-    readScreen(ses->winx, ses->winy, charCount, 1, characters);
+    readIndexedScreen(ses->winx, ses->winy, charCount, 1, characters);
 
     for (charIndex=0; charIndex<charCount; charIndex+=1) {
       wchar_t text = characters[charIndex].text;
@@ -407,14 +517,10 @@ handleNavigationCommands (int command, void *data) {
       } State;
 
       State state = STARTING;
-      ScreenCharacter characters[scr.cols];
       int line = ses->winy;
 
       while (1) {
-        int isBlankLine;
-
-        readScreenRow(line, scr.cols, characters);
-        isBlankLine = isAllSpaceCharacters(characters, scr.cols);
+        int isBlankLine = isBlankScreenRow(line);
 
         switch (state) {
           case STARTING:
@@ -451,17 +557,12 @@ handleNavigationCommands (int command, void *data) {
     }
 
     case BRL_CMD_NXPGRPH: {
-      int width = scr.cols;
-      ScreenCharacter characters[width];
-
       int found = 0;
       int findBlankLine = 1;
       int line = ses->winy;
 
       while (line < scr.rows) {
-        readScreenRow(line, width, characters);
-
-        if (isAllSpaceCharacters(characters, width) == findBlankLine) {
+        if (isBlankScreenRow(line) == findBlankLine) {
           if (!findBlankLine) {
             ses->winy = line;
             ses->winx = 0;
@@ -494,7 +595,7 @@ handleNavigationCommands (int command, void *data) {
       {
         size_t length = scr.cols;
         ScreenCharacter characters[length];
-        readScreenRow(ses->winy, length, characters);
+        readIndexedScreenRow(ses->winy, length, characters);
 
         if (promptPatterns) {
           findRow(length, increment, testPromptPatterns, characters);
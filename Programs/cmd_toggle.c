@@ -121,6 +121,26 @@ toggleFunctionalSetting (
   return result;
 }
 
+static void
+shiftSessionRows (int amount) {
+  if (amount) {
+    int *rows[] = {
+      &ses->winy, &ses->moty, &ses->trky,
+      &ses->dcty, &ses->ptry, &ses->spky,
+      NULL
+    };
+
+    for (int **row=rows; *row; row+=1) {
+      if (**row >= 0) **row = MAX(**row + amount, 0);
+    }
+
+    for (unsigned int index=0; index<ARRAY_COUNT(ses->marks); index+=1) {
+      ScreenLocation *mark = &ses->marks[index];
+      mark->row = MAX(mark->row + amount, 0);
+    }
+  }
+}
+
 static int
 handleToggleCommands (int command, void *data) {
   switch (command & BRL_MSK_CMD) {
@@ -265,6 +285,8 @@ handleToggleCommands (int command, void *data) {
       break;
 
     case BRL_CMD_FREEZE: {
+      /* The frozen screen has the scrollback above what was visible. */
+      static int scrollbackRows = 0;
       unsigned char setting;
 
       if (isMainScreen()) {
@@ -279,10 +301,20 @@ handleToggleCommands (int command, void *data) {
       switch (toggleSetting(&setting, command, ALERT_SCREEN_UNFROZEN, ALERT_SCREEN_FROZEN)) {
         case TOGGLE_OFF:
           deactivateSpecialScreen(SCR_FROZEN);
+          shiftSessionRows(-scrollbackRows);
+          scrollbackRows = 0;
           break;
 
         case TOGGLE_ON:
-          if (!activateSpecialScreen(SCR_FROZEN)) alert(ALERT_COMMAND_REJECTED);
+          if (activateSpecialScreen(SCR_FROZEN)) {
+            ScreenDescription description;
+            describeScreen(&description);
+
+            scrollbackRows = MAX(description.rows - scr.rows, 0);
+            shiftSessionRows(scrollbackRows);
+          } else {
+            alert(ALERT_COMMAND_REJECTED);
+          }
           break;
 
         default:
@@ -29,10 +29,14 @@
 #include "parameters.h"
 #include "embed.h"
 #include "log.h"
+#include "log_history.h"
 #include "report.h"
 #include "strfmt.h"
 #include "pgmprivs.h"
 #include "lock.h"
+#include "thread.h"
+#include "startup.h"
+#include "memusage.h"
 #include "activity.h"
 #include "update.h"
 #include "cmd.h"
@@ -236,6 +240,9 @@ static int opt_noDaemon;
 static int opt_standardError;
 static char *opt_logLevel;
 static char *opt_logFile;
+static char *opt_logHistory;
+static int opt_startupReport;
+static char *opt_startupTrace;
 static int opt_bootParameters = 1;
 static int opt_environmentVariables;
 static char *opt_messageTime;
@@ -763,6 +770,26 @@ BEGIN_OPTION_TABLE(programOptions)
     .description = strtext("Path to log file.")
   },
 
+  { .word = "log-history",
+    .flags = OPT_Hidden | OPT_Config | OPT_EnvVar,
+    .argument = strtext("entries[,bytes]"),
+    .setting.string = &opt_logHistory,
+    .description = strtext("Limits on the number of log messages, and on their total size, retained for the Log Messages menu.")
+  },
+
+  { .word = "startup-report",
+    .flags = OPT_Hidden | OPT_EnvVar,
+    .setting.flag = &opt_startupReport,
+    .description = strtext("Log how long each phase of start-up took.")
+  },
+
+  { .word = "startup-trace",
+    .flags = OPT_Hidden | OPT_EnvVar,
+    .argument = strtext("file"),
+    .setting.string = &opt_startupTrace,
+    .description = strtext("Path to a file to which a trace (in Chrome trace event format) of the start-up phases is to be written.")
+  },
+
   { .word = "verify",
     .letter = 'v',
     .setting.flag = &opt_verify,
@@ -836,6 +863,35 @@ setLogLevels (void) {
   }
 }
 
+static void
+setLogHistoryLimits (void) {
+  if (*opt_logHistory) {
+    int ok = 0;
+    int count;
+    char **limits = splitString(opt_logHistory, ',', &count);
+
+    if (limits) {
+      if (count <= 2) {
+        static const int minimum = 1;
+        int entries = LOG_MESSAGE_HISTORY_ENTRY_LIMIT;
+        int bytes = LOG_MESSAGE_HISTORY_BYTE_LIMIT;
+
+        if (validateInteger(&entries, limits[0], &minimum, NULL)) {
+          if ((count < 2) || validateInteger(&bytes, limits[1], &minimum, NULL)) {
+            ok = setLogMessageHistoryLimits(entries, bytes);
+          }
+        }
+      }
+
+      deallocateStrings(limits);
+    }
+
+    if (!ok) {
+      logMessage(LOG_ERR, "%s: %s", gettext("invalid log history limits"), opt_logHistory);
+    }
+  }
+}
+
 static void
 establishPrivileges (void) {
   const char *platform = getPrivilegeParametersPlatform();
@@ -859,7 +915,9 @@ brlttyPrepare (int argc, char *argv[]) {
       .configurationFile = &opt_configurationFile,
       .applicationName = "brltty"
     };
+    beginStartupPhase("options");
     ProgramExitStatus exitStatus = processOptions(&descriptor, &argc, &argv);
+    endStartupPhase();
 
     switch (exitStatus) {
       case PROG_EXIT_SYNTAX:
@@ -875,11 +933,14 @@ brlttyPrepare (int argc, char *argv[]) {
     logMessage(LOG_ERR, "%s: %s", gettext("excess argument"), argv[0]);
   }
 
+  setStartupReport(opt_startupReport, opt_startupTrace);
+
   setMessagesDirectory(opt_localeDirectory);
   setUpdatableDirectory(opt_updatableDirectory);
   setWritableDirectory(opt_writableDirectory);
 
   setLogLevels();
+  setLogHistoryLimits();
   onProgramExit("log", exitLog, NULL);
 
   if (*opt_logFile) {
@@ -902,15 +963,288 @@ brlttyPrepare (int argc, char *argv[]) {
   return PROG_EXIT_SUCCESS;
 }
 
+static KeyTable *
+loadKeyboardTable (const char *name) {
+  KeyTable *table = NULL;
+  char *path = makeKeyboardTablePath(opt_tablesDirectory, name);
+
+  if (path) {
+    logMessage(LOG_DEBUG, "compiling keyboard table: %s", path);
+
+    if (!(table = compileKeyTable(path, KEY_NAME_TABLES(keyboard)))) {
+      logMessage(LOG_ERR, "%s: %s", gettext("cannot compile keyboard table"), path);
+    }
+
+    free(path);
+  }
+
+  return table;
+}
+
+#if defined(GOT_PTHREADS) && defined(THREAD_LOCAL)
+/* The tables are independent of one another and compiling them is a
+ * significant part of startup, so compile them concurrently while the rest
+ * of startup proceeds. Each one is then claimed (and joined) at the point
+ * where it would otherwise have been compiled.
+ */
+
+typedef void *TablePreloadFunction (const char *name);
+typedef void TableDestroyFunction (void *table);
+
+typedef struct {
+  const char *threadName;
+  const char *phaseName;
+  TablePreloadFunction *load;
+  TableDestroyFunction *destroy;
+
+  char *name;
+  void *table;
+  pthread_t thread;
+  unsigned started:1;
+} TablePreloader;
+
+static void *
+preloadTextTable (const char *name) {
+  TextTable *table = compileNamedTextTable(opt_tablesDirectory, name);
+  if (!table) logMessage(LOG_ERR, "%s: %s", gettext("cannot load text table"), name);
+  return table;
+}
+
+static void
+destroyPreloadedTextTable (void *table) {
+  destroyTextTable(table);
+}
+
+static TablePreloader textTablePreloader = {
+  .threadName = "ttb-compile",
+  .phaseName = "text table compilation",
+  .load = preloadTextTable,
+  .destroy = destroyPreloadedTextTable
+};
+
+static void *
+preloadContractionTable (const char *name) {
+  ContractionTable *table = compileNamedContractionTable(opt_tablesDirectory, name);
+  if (!table) logMessage(LOG_ERR, "%s: %s", gettext("cannot load contraction table"), name);
+  return table;
+}
+
+static void
+destroyPreloadedContractionTable (void *table) {
+  destroyContractionTable(table);
+}
+
+static TablePreloader contractionTablePreloader = {
+  .threadName = "ctb-compile",
+  .phaseName = "contraction table compilation",
+  .load = preloadContractionTable,
+  .destroy = destroyPreloadedContractionTable
+};
+
+static void *
+preloadAttributesTable (const char *name) {
+  AttributesTable *table = compileNamedAttributesTable(opt_tablesDirectory, name);
+  if (!table) logMessage(LOG_ERR, "%s: %s", gettext("cannot load attributes table"), name);
+  return table;
+}
+
+static void
+destroyPreloadedAttributesTable (void *table) {
+  destroyAttributesTable(table);
+}
+
+static TablePreloader attributesTablePreloader = {
+  .threadName = "atb-compile",
+  .phaseName = "attributes table compilation",
+  .load = preloadAttributesTable,
+  .destroy = destroyPreloadedAttributesTable
+};
+
+static void *
+preloadKeyboardTable (const char *name) {
+  return loadKeyboardTable(name);
+}
+
+static void
+destroyPreloadedKeyboardTable (void *table) {
+  destroyKeyTable(table);
+}
+
+static TablePreloader keyboardTablePreloader = {
+  .threadName = "ktb-compile",
+  .phaseName = "keyboard table compilation",
+  .load = preloadKeyboardTable,
+  .destroy = destroyPreloadedKeyboardTable
+};
+
+#define TABLE_PRELOADER(type) (&type##TablePreloader)
+
+static TablePreloader *const tablePreloaders[] = {
+  TABLE_PRELOADER(text),
+  TABLE_PRELOADER(contraction),
+  TABLE_PRELOADER(attributes),
+  TABLE_PRELOADER(keyboard),
+};
+
+static THREAD_FUNCTION(runTablePreloader) {
+  TablePreloader *tp = argument;
+
+  beginStartupPhase(tp->phaseName);
+  tp->table = tp->load(tp->name);
+  endStartupPhase();
+
+  releaseDataVariables();
+  return NULL;
+}
+
+static void
+startTablePreloader (TablePreloader *tp, const char *name) {
+  if (!*name) return;
+
+  if ((tp->name = strdup(name))) {
+    if (!createThread(tp->threadName, &tp->thread, NULL, runTablePreloader, tp)) {
+      tp->started = 1;
+      return;
+    }
+
+    free(tp->name);
+    tp->name = NULL;
+  } else {
+    logMallocError();
+  }
+}
+
+static void
+startLocaleTablePreloader (TablePreloader *tp, const char *option, char *(*getTableForLocale) (const char *directory)) {
+  if (strcmp(option, optionOperand_autodetect) == 0) {
+    char *name = getTableForLocale(opt_tablesDirectory);
+
+    if (name) {
+      startTablePreloader(tp, name);
+      free(name);
+    }
+  } else {
+    startTablePreloader(tp, option);
+  }
+}
+
+static int
+anchorTablesDirectory (void) {
+  if (isAbsolutePath(opt_tablesDirectory)) return 1;
+
+  // the working directory is process-wide and may be changed (temporarily)
+  // by the main thread, e.g. when a files menu item is begun
+  char *directory = getWorkingDirectory();
+  if (!directory) return 0;
+
+  char *path = makePath(directory, opt_tablesDirectory);
+  free(directory);
+  if (!path) return 0;
+
+  int changed = changeStringSetting(&opt_tablesDirectory, path);
+  free(path);
+  return changed;
+}
+
+static void
+startTablePreloaders (void) {
+  // these are lazily initialized so make sure the workers don't race to do it
+  loadMessageCatalog();
+  if (!getGlobalVariables(1)) return;
+  if (!anchorTablesDirectory()) return;
+
+  startLocaleTablePreloader(TABLE_PRELOADER(text), opt_textTable, getTextTableForLocale);
+  startLocaleTablePreloader(TABLE_PRELOADER(contraction), opt_contractionTable, getContractionTableForLocale);
+  startTablePreloader(TABLE_PRELOADER(attributes), opt_attributesTable);
+
+  if (strcmp(opt_keyboardTable, optionOperand_off) != 0) {
+    startTablePreloader(TABLE_PRELOADER(keyboard), opt_keyboardTable);
+  }
+}
+
+static void
+discardPreloadedTable (TablePreloader *tp) {
+  if (tp->started) {
+    pthread_join(tp->thread, NULL);
+    tp->started = 0;
+  }
+
+  if (tp->table) {
+    tp->destroy(tp->table);
+    tp->table = NULL;
+  }
+
+  if (tp->name) {
+    free(tp->name);
+    tp->name = NULL;
+  }
+}
+
+static void
+discardPreloadedTables (void) {
+  for (unsigned int index=0; index<ARRAY_COUNT(tablePreloaders); index+=1) {
+    discardPreloadedTable(tablePreloaders[index]);
+  }
+}
+
+static int
+takePreloadedTable (TablePreloader *tp, const char *name, void **table) {
+  if (tp->started) {
+    pthread_join(tp->thread, NULL);
+    tp->started = 0;
+  }
+
+  if (tp->name) {
+    if (strcmp(name, tp->name) == 0) {
+      *table = tp->table;
+      tp->table = NULL;
+      discardPreloadedTable(tp);
+      return 1;
+    }
+
+    discardPreloadedTable(tp);
+  }
+
+  return 0;
+}
+
+#else /* preload tables */
+typedef void TablePreloader;
+#define TABLE_PRELOADER(type) NULL
+
+static inline void
+startTablePreloaders (void) {
+}
+
+static inline void
+discardPreloadedTables (void) {
+}
+
+static inline int
+takePreloadedTable (TablePreloader *tp, const char *name, void **table) {
+  return 0;
+}
+#endif /* preload tables */
+
 static int
 setTextTable (const char *name) {
+  void *table;
+
   if (!name) name = "";
-  if (!replaceTextTable(opt_tablesDirectory, name)) return 0;
+
+  if (takePreloadedTable(TABLE_PRELOADER(text), name, &table)) {
+    if (!table) return 0;
+    installTextTable(table);
+  } else if (!replaceTextTable(opt_tablesDirectory, name)) {
+    return 0;
+  }
 
   if (!*name) name = TEXT_TABLE;
   changeStringSetting(&opt_textTable, name);
 
   api.updateParameter(BRLAPI_PARAM_COMPUTER_BRAILLE_TABLE, 0);
+
+  logMemoryUsage("text table changed");
   return 1;
 }
 
@@ -945,13 +1279,23 @@ exitTextTable (void *data) {
 
 static int
 setContractionTable (const char *name) {
+  void *table;
+
   if (!name) name = "";
-  if (!replaceContractionTable(opt_tablesDirectory, name)) return 0;
+
+  if (takePreloadedTable(TABLE_PRELOADER(contraction), name, &table)) {
+    if (!table) return 0;
+    installContractionTable(table);
+  } else if (!replaceContractionTable(opt_tablesDirectory, name)) {
+    return 0;
+  }
 
   if (!*name) name = CONTRACTION_TABLE;
   changeStringSetting(&opt_contractionTable, name);
 
   api.updateParameter(BRLAPI_PARAM_LITERARY_BRAILLE_TABLE, 0);
+
+  logMemoryUsage("contraction table changed");
   return 1;
 }
 
@@ -1032,12 +1376,21 @@ setTextAndContractionTables (void) {
 
 int
 changeAttributesTable (const char *name) {
+  void *table;
+
   if (!name) name = "";
-  if (!replaceAttributesTable(opt_tablesDirectory, name)) return 0;
+
+  if (takePreloadedTable(TABLE_PRELOADER(attributes), name, &table)) {
+    if (!table) return 0;
+    installAttributesTable(table);
+  } else if (!replaceAttributesTable(opt_tablesDirectory, name)) {
+    return 0;
+  }
 
   if (!*name) name = ATTRIBUTES_TABLE;
   changeStringSetting(&opt_attributesTable, name);
 
+  logMemoryUsage("attributes table changed");
   return 1;
 }
 
@@ -1277,16 +1630,12 @@ changeKeyboardTable (const char *name) {
   if (strcmp(name, optionOperand_off) == 0) name = "";
 
   if (*name) {
-    char *path = makeKeyboardTablePath(opt_tablesDirectory, name);
-
-    if (path) {
-      logMessage(LOG_DEBUG, "compiling keyboard table: %s", path);
-
-      if (!(table = compileKeyTable(path, KEY_NAME_TABLES(keyboard)))) {
-        logMessage(LOG_ERR, "%s: %s", gettext("cannot compile keyboard table"), path);
-      }
+    void *preloaded;
 
-      free(path);
+    if (takePreloadedTable(TABLE_PRELOADER(keyboard), name, &preloaded)) {
+      table = preloaded;
+    } else {
+      table = loadKeyboardTable(name);
     }
 
     if (!table) return 0;
@@ -1313,6 +1662,8 @@ changeKeyboardTable (const char *name) {
   logMessage(LOG_DEBUG, "keyboard table changed: %s -> %s", opt_keyboardTable, name);
 
   changeStringSetting(&opt_keyboardTable, name);
+
+  logMemoryUsage("keyboard table changed");
   return 1;
 }
 
@@ -1737,7 +2088,11 @@ constructBrailleDriver (void) {
 
         if (keyTablePath) {
           if (brl.keyNames) {
-            if ((brl.keyTable = compileKeyTable(keyTablePath, brl.keyNames))) {
+            beginStartupPhase("braille key table");
+            brl.keyTable = compileKeyTable(keyTablePath, brl.keyNames);
+            endStartupPhase();
+
+            if (brl.keyTable) {
               logMessage(LOG_INFO, "%s: %s", gettext("Key Table"), keyTablePath);
 
               setKeyTableLogLabel(brl.keyTable, "brl");
@@ -1787,7 +2142,11 @@ isBrailleOnline (void) {
 
 static int
 initializeBrailleDriver (const char *code, int verify) {
-  if ((braille = loadBrailleDriver(code, &brailleObject, opt_driversDirectory))) {
+  beginStartupPhase("braille driver load");
+  braille = loadBrailleDriver(code, &brailleObject, opt_driversDirectory);
+  endStartupPhase();
+
+  if (braille) {
     brailleDriverParameters = getParameters(braille->parameters,
                                             braille->definition.code,
                                             brailleParameters);
@@ -1799,10 +2158,12 @@ initializeBrailleDriver (const char *code, int verify) {
         logMessage(LOG_DEBUG, "initializing braille driver: %s -> %s",
                    braille->definition.code, brailleDevice);
 
-        if (constructBrailleDriver()) {
-          brailleDriver = braille;
-          constructed = 1;
-        }
+        beginStartupPhase("braille driver construction");
+          if (constructBrailleDriver()) {
+            brailleDriver = braille;
+            constructed = 1;
+          }
+        endStartupPhase();
       }
 
       if (constructed) {
@@ -1850,7 +2211,7 @@ initializeBrailleDriver (const char *code, int verify) {
 }
 
 static int
-activateBrailleDriver (int verify) {
+activateBrailleDevice (int verify) {
   int oneDevice = brailleDevices[0] && !brailleDevices[1];
   const char *const *device = (const char *const *)brailleDevices;
 
@@ -1920,6 +2281,15 @@ activateBrailleDriver (int verify) {
   return 0;
 }
 
+static int
+activateBrailleDriver (int verify) {
+  beginStartupPhase("braille driver activation");
+  int activated = activateBrailleDevice(verify);
+  endStartupPhase();
+
+  return activated;
+}
+
 static void
 deactivateBrailleDriver (void) {
   if (brailleDriver) {
@@ -2004,7 +2374,13 @@ prepareBrailleDriverActivity (void *data) {
 
 static int
 startBrailleDriverActivity (void *data) {
-  return startBrailleDriver();
+  int started = startBrailleDriver();
+
+  // the first braille driver start attempt is the end of startup
+  finishStartupReport();
+  logMemoryUsage("start-up");
+
+  return started;
 }
 
 static void
@@ -2234,7 +2610,11 @@ destructSpeechDriver (void) {
 
 static int
 initializeSpeechDriver (const char *code, int verify) {
-  if ((speech = loadSpeechDriver(code, &speechObject, opt_driversDirectory))) {
+  beginStartupPhase("speech driver load");
+  speech = loadSpeechDriver(code, &speechObject, opt_driversDirectory);
+  endStartupPhase();
+
+  if (speech) {
     speechDriverParameters = getParameters(speech->parameters,
                                            speech->definition.code,
                                            speechParameters);
@@ -2246,10 +2626,12 @@ initializeSpeechDriver (const char *code, int verify) {
         logMessage(LOG_DEBUG, "initializing speech driver: %s",
                    speech->definition.code);
 
-        if (constructSpeechDriver()) {
-          constructed = 1;
-          speechDriver = speech;
-        }
+        beginStartupPhase("speech driver construction");
+          if (constructSpeechDriver()) {
+            constructed = 1;
+            speechDriver = speech;
+          }
+        endStartupPhase();
       }
 
       if (constructed) {
@@ -2292,7 +2674,11 @@ activateSpeechDriver (int verify) {
     .initializeDriver = initializeSpeechDriver
   };
 
-  return activateDriver(&data, verify);
+  beginStartupPhase("speech driver activation");
+  int activated = activateDriver(&data, verify);
+  endStartupPhase();
+
+  return activated;
 }
 
 static void
@@ -2461,7 +2847,11 @@ changeSpeechParameters (const char *parameters) {
 
 static int
 initializeScreenDriver (const char *code, int verify) {
-  if ((screen = loadScreenDriver(code, &screenObject, opt_driversDirectory))) {
+  beginStartupPhase("screen driver load");
+  screen = loadScreenDriver(code, &screenObject, opt_driversDirectory);
+  endStartupPhase();
+
+  if (screen) {
     screenDriverParameters = getParameters(
       getScreenParameters(screen),
       screen->definition.code,
@@ -2477,10 +2867,12 @@ initializeScreenDriver (const char *code, int verify) {
           screen->definition.code
         );
 
-        if (constructScreenDriver(screenDriverParameters)) {
-          constructed = 1;
-          screenDriver = screen;
-        }
+        beginStartupPhase("screen driver construction");
+          if (constructScreenDriver(screenDriverParameters)) {
+            constructed = 1;
+            screenDriver = screen;
+          }
+        endStartupPhase();
       }
 
       if (constructed) {
@@ -2523,7 +2915,11 @@ activateScreenDriver (int verify) {
     .initializeDriver = initializeScreenDriver
   };
 
-  return activateDriver(&data, verify);
+  beginStartupPhase("screen driver activation");
+  int activated = activateDriver(&data, verify);
+  endStartupPhase();
+
+  return activated;
 }
 
 static void
@@ -2948,9 +3344,14 @@ brlttyStart (void) {
    * be used instead.
    */
 
+  startTablePreloaders();
+
   changeScreenDriver(opt_screenDriver);
   changeScreenParameters(opt_screenParameters);
+
+  beginStartupPhase("special screens");
   beginSpecialScreens();
+  endStartupPhase();
   onProgramExit("screen-data", exitScreenData, NULL);
 
   suppressTuneDeviceOpenErrors();
@@ -2969,8 +3370,10 @@ brlttyStart (void) {
   logProperty(opt_configurationFile, "configurationFile", gettext("Configuration File"));
   logProperty(opt_preferencesFile, "preferencesFile", gettext("Preferences File"));
 
+  beginStartupPhase("preferences");
   resetPreferences();
   loadPreferences(0);
+  endStartupPhase();
 
   if (opt_promptPatterns && *opt_promptPatterns) {
     int count;
@@ -2990,9 +3393,12 @@ brlttyStart (void) {
   logProperty(opt_driversDirectory, "driversDirectory", gettext("Drivers Directory"));
   logProperty(opt_tablesDirectory, "tablesDirectory", gettext("Tables Directory"));
 
+  beginStartupPhase("tables");
   setTextAndContractionTables();
   setAttributesTable();
   setKeyboardTable();
+  discardPreloadedTables();
+  endStartupPhase();
 
   /* initialize screen driver */
   if (opt_verify) {
@@ -3043,9 +3449,16 @@ brlttyStart (void) {
   }
 #endif /* ENABLE_SPEECH_SUPPORT */
 
+  beginStartupPhase("api server");
   startApiServer();
+  endStartupPhase();
 
-  if (!opt_verify) notifyServiceReady();
+  if (opt_verify) {
+    finishStartupReport();
+    logMemoryUsage("start-up");
+  } else {
+    notifyServiceReady();
+  }
 
   return opt_verify? PROG_EXIT_FORCE: PROG_EXIT_SUCCESS;
 }
@@ -1143,21 +1143,31 @@ isContracting (void) {
 }
 
 int
-getUncontractedCursorOffset (int x, int y) {
-  return ((y == ses->winy) && (x >= ses->winx) && (x < scr.cols))?
+getUncontractedRowOffset (int x, int y, int row) {
+  return ((y == row) && (x >= ses->winx) && (x < scr.cols))?
          (x - ses->winx):
          BRL_NO_CURSOR;
 }
 
 int
-getContractedCursor (void) {
-  int offset = getUncontractedCursorOffset(scr.posx, scr.posy);
+getUncontractedCursorOffset (int x, int y) {
+  return getUncontractedRowOffset(x, y, ses->winy);
+}
+
+int
+getContractedRowCursor (int row) {
+  int offset = getUncontractedRowOffset(scr.posx, scr.posy, row);
 
   return ((offset != BRL_NO_CURSOR) && !ses->hideScreenCursor)?
          offset:
          CTB_NO_CURSOR;
 }
 
+int
+getContractedCursor (void) {
+  return getContractedRowCursor(ses->winy);
+}
+
 int
 getContractedLength (unsigned int outputLimit) {
   int inputLength = scr.cols - ses->winx;
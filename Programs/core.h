@@ -141,7 +141,9 @@ extern int contractedTrack;
 extern int *contractedOffsets;
 
 extern int isContracting (void);
+extern int getUncontractedRowOffset (int x, int y, int row);
 extern int getUncontractedCursorOffset (int x, int y);
+extern int getContractedRowCursor (int row);
 extern int getContractedCursor (void);
 extern int getContractedLength (unsigned int outputLimit);
 
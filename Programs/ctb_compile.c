@@ -27,6 +27,7 @@
 #include "file.h"
 #include "datafile.h"
 #include "dataarea.h"
+#include "memusage.h"
 #include "unicode.h"
 #include "utf8.h"
 #include "charset.h"
@@ -707,22 +708,32 @@ initializeCommonFields (ContractionTable *table) {
   table->rules.size = 0;
   table->rules.count = 0;
 
-  table->cache.input.characters = NULL;
-  table->cache.input.size = 0;
-  table->cache.input.count = 0;
+  for (unsigned int index=0; index<CTB_CACHE_ENTRIES; index+=1) {
+    ContractionCacheEntry *entry = &table->cache.entries[index];
 
-  table->cache.output.cells = NULL;
-  table->cache.output.size = 0;
-  table->cache.output.count = 0;
+    entry->input.characters = NULL;
+    entry->input.size = 0;
+    entry->input.count = 0;
 
-  table->cache.offsets.array = NULL;
-  table->cache.offsets.size = 0;
-  table->cache.offsets.count = 0;
+    entry->output.cells = NULL;
+    entry->output.size = 0;
+    entry->output.count = 0;
+
+    entry->offsets.array = NULL;
+    entry->offsets.size = 0;
+    entry->offsets.count = 0;
+
+    entry->lastUsed = 0;
+  }
+
+  table->cache.clock = 0;
+  memset(&table->statistics, 0, sizeof(table->statistics));
 }
 
 static void
 destroyCommonFields (ContractionTable *table) {
   if (table->characters.array) {
+    subtractMemoryUsage(MEMORY_TABLES, ARRAY_SIZE(table->characters.array, table->characters.size));
     free(table->characters.array);
     table->characters.array = NULL;
   }
@@ -738,19 +749,23 @@ destroyCommonFields (ContractionTable *table) {
     table->rules.array = NULL;
   }
 
-  if (table->cache.input.characters) {
-    free(table->cache.input.characters);
-    table->cache.input.characters = NULL;
-  }
+  for (unsigned int index=0; index<CTB_CACHE_ENTRIES; index+=1) {
+    ContractionCacheEntry *entry = &table->cache.entries[index];
 
-  if (table->cache.output.cells) {
-    free(table->cache.output.cells);
-    table->cache.output.cells = NULL;
-  }
+    if (entry->input.characters) {
+      free(entry->input.characters);
+      entry->input.characters = NULL;
+    }
+
+    if (entry->output.cells) {
+      free(entry->output.cells);
+      entry->output.cells = NULL;
+    }
 
-  if (table->cache.offsets.array) {
-    free(table->cache.offsets.array);
-    table->cache.offsets.array = NULL;
+    if (entry->offsets.array) {
+      free(entry->offsets.array);
+      entry->offsets.array = NULL;
+    }
   }
 }
 
@@ -759,6 +774,7 @@ destroyContractionTable_native (ContractionTable *table) {
   destroyCommonFields(table);
 
   if (table->data.internal.size) {
+    subtractMemoryUsage(MEMORY_TABLES, table->data.internal.size);
     free(table->data.internal.header.fields);
     free(table);
   }
@@ -786,6 +802,40 @@ newContractionTable (const unsigned char *bytes, size_t size) {
   return table;
 }
 
+static void
+destroyContractionTable_duplicate (ContractionTable *table) {
+  destroyCommonFields(table);
+  free(table);
+}
+
+static const ContractionTableManagementMethods duplicateManagementMethods = {
+  .destroy = destroyContractionTable_duplicate
+};
+
+ContractionTable *
+duplicateContractionTable (ContractionTable *table) {
+  const ContractionTableManagementMethods *methods = table->managementMethods;
+
+  if ((methods == &nativeManagementMethods) || (methods == &duplicateManagementMethods)) {
+    ContractionTable *duplicate;
+
+    if ((duplicate = malloc(sizeof(*duplicate)))) {
+      duplicate->managementMethods = &duplicateManagementMethods;
+      duplicate->translationMethods = table->translationMethods;
+      initializeCommonFields(duplicate);
+
+      duplicate->data.internal = table->data.internal;
+      return duplicate;
+    } else {
+      logMallocError();
+    }
+  } else {
+    logMessage(LOG_DEBUG, "contraction table can't be duplicated");
+  }
+
+  return NULL;
+}
+
 static ContractionTable *
 compileContractionTable_native (const char *name) {
   ContractionTable *table = NULL;
@@ -819,8 +869,12 @@ compileContractionTable_native (const char *name) {
 
             if (processDataFile(name, &parameters)) {
               if (saveCharacterTable(&ctd)) {
-                table = newContractionTable(getDataItem(ctd.area, 0), getDataSize(ctd.area));
-                resetDataArea(ctd.area);
+                shrinkDataArea(ctd.area);
+
+                if ((table = newContractionTable(getDataItem(ctd.area, 0), getDataSize(ctd.area)))) {
+                  addMemoryUsage(MEMORY_TABLES, table->data.internal.size);
+                  resetDataArea(ctd.area);
+                }
               }
             }
           }
@@ -28,6 +28,37 @@ extern "C" {
 #define BYTE unsigned char
 
 #define HASHNUM 1087
+
+/* Recent translations are remembered so that text which hasn't changed
+ * (e.g. each of the rows of a multi-line display) needn't be contracted again. */
+#define CTB_CACHE_ENTRIES 0X10
+
+typedef struct {
+  struct {
+    wchar_t *characters;
+    unsigned int size;
+    unsigned int count;
+    unsigned int consumed;
+  } input;
+
+  struct {
+    unsigned char *cells;
+    unsigned int size;
+    unsigned int count;
+    unsigned int maximum;
+  } output;
+
+  struct {
+    int *array;
+    unsigned int size;
+    unsigned int count;
+  } offsets;
+
+  int cursorOffset;
+  unsigned char expandCurrentWord;
+  unsigned char capitalizationMode;
+  unsigned long int lastUsed;
+} ContractionCacheEntry;
 #define CTH(x) (((x[0]<<8)+x[1])%HASHNUM)
 
 typedef uint32_t ContractionTableOffset;
@@ -160,31 +191,16 @@ struct ContractionTableStruct {
   } rules;
 
   struct {
-    struct {
-      wchar_t *characters;
-      unsigned int size;
-      unsigned int count;
-      unsigned int consumed;
-    } input;
-
-    struct {
-      unsigned char *cells;
-      unsigned int size;
-      unsigned int count;
-      unsigned int maximum;
-    } output;
-
-    struct {
-      int *array;
-      unsigned int size;
-      unsigned int count;
-    } offsets;
-
-    int cursorOffset;
-    unsigned char expandCurrentWord;
-    unsigned char capitalizationMode;
+    ContractionCacheEntry entries[CTB_CACHE_ENTRIES];
+    unsigned long int clock;
   } cache;
 
+  struct {
+    unsigned long int cacheHits;
+    unsigned long int cacheMisses;
+    unsigned long int bufferAllocations;
+  } statistics;
+
   union {
     InternalContractionTable internal;
 
@@ -22,6 +22,7 @@
 
 #include "log.h"
 #include "lock.h"
+#include "memusage.h"
 #include "ctb_translate.h"
 #include "ttb.h"
 #include "unicode.h"
@@ -91,6 +92,8 @@ addCharacterEntry (BrailleContractionData *bcd, wchar_t character, unsigned int
       return NULL;
     }
 
+    addMemoryUsage(MEMORY_TABLES, ARRAY_SIZE(newArray, (newSize - table->characters.size)));
+    table->statistics.bufferAllocations += 1;
     table->characters.array = newArray;
     table->characters.size = newSize;
   }
@@ -143,102 +146,135 @@ makeCachedCursorOffset (BrailleContractionData *bcd) {
 }
 
 static int
-checkCache (BrailleContractionData *bcd) {
-  if (!bcd->table->cache.input.characters) return 0;
-  if (!bcd->table->cache.output.cells) return 0;
-  if (bcd->input.offsets && !bcd->table->cache.offsets.count) return 0;
-  if (bcd->table->cache.output.maximum != getOutputCount(bcd)) return 0;
-  if (bcd->table->cache.cursorOffset != makeCachedCursorOffset(bcd)) return 0;
-  if (bcd->table->cache.expandCurrentWord != prefs.expandCurrentWord) return 0;
-  if (bcd->table->cache.capitalizationMode != prefs.capitalizationMode) return 0;
+checkCacheEntry (BrailleContractionData *bcd, const ContractionCacheEntry *entry) {
+  if (!entry->lastUsed) return 0;
+  if (!entry->input.characters) return 0;
+  if (!entry->output.cells) return 0;
+  if (bcd->input.offsets && !entry->offsets.count) return 0;
+  if (entry->output.maximum != getOutputCount(bcd)) return 0;
+  if (entry->cursorOffset != makeCachedCursorOffset(bcd)) return 0;
+  if (entry->expandCurrentWord != prefs.expandCurrentWord) return 0;
+  if (entry->capitalizationMode != prefs.capitalizationMode) return 0;
 
   {
     unsigned int count = getInputCount(bcd);
-    if (bcd->table->cache.input.count != count) return 0;
-    if (wmemcmp(bcd->input.begin, bcd->table->cache.input.characters, count) != 0) return 0;
+    if (entry->input.count != count) return 0;
+    if (wmemcmp(bcd->input.begin, entry->input.characters, count) != 0) return 0;
   }
 
   return 1;
 }
 
+static ContractionCacheEntry *
+checkCache (BrailleContractionData *bcd) {
+  for (unsigned int index=0; index<CTB_CACHE_ENTRIES; index+=1) {
+    ContractionCacheEntry *entry = &bcd->table->cache.entries[index];
+
+    if (checkCacheEntry(bcd, entry)) {
+      entry->lastUsed = ++bcd->table->cache.clock;
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+static ContractionCacheEntry *
+getLeastRecentlyUsedCacheEntry (BrailleContractionData *bcd) {
+  ContractionCacheEntry *oldest = &bcd->table->cache.entries[0];
+
+  for (unsigned int index=1; index<CTB_CACHE_ENTRIES; index+=1) {
+    ContractionCacheEntry *entry = &bcd->table->cache.entries[index];
+    if (entry->lastUsed < oldest->lastUsed) oldest = entry;
+  }
+
+  return oldest;
+}
+
 static void
 updateCache (BrailleContractionData *bcd) {
+  ContractionCacheEntry *entry = getLeastRecentlyUsedCacheEntry(bcd);
+  entry->lastUsed = ++bcd->table->cache.clock;
+
   {
     unsigned int count = getInputCount(bcd);
 
-    if (count > bcd->table->cache.input.size) {
+    if (count > entry->input.size) {
       unsigned int newSize = count | 0X7F;
       wchar_t *newCharacters = malloc(ARRAY_SIZE(newCharacters, newSize));
 
       if (!newCharacters) {
         logMallocError();
-        bcd->table->cache.input.count = 0;
+        entry->input.count = 0;
         goto inputDone;
       }
 
-      if (bcd->table->cache.input.characters) free(bcd->table->cache.input.characters);
-      bcd->table->cache.input.characters = newCharacters;
-      bcd->table->cache.input.size = newSize;
+      bcd->table->statistics.bufferAllocations += 1;
+      if (entry->input.characters) free(entry->input.characters);
+      entry->input.characters = newCharacters;
+      entry->input.size = newSize;
     }
 
-    wmemcpy(bcd->table->cache.input.characters, bcd->input.begin, count);
-    bcd->table->cache.input.count = count;
-    bcd->table->cache.input.consumed = getInputConsumed(bcd);
+    wmemcpy(entry->input.characters, bcd->input.begin, count);
+    entry->input.count = count;
+    entry->input.consumed = getInputConsumed(bcd);
   }
 inputDone:
 
   {
     unsigned int count = getOutputConsumed(bcd);
 
-    if (count > bcd->table->cache.output.size) {
+    if (count > entry->output.size) {
       unsigned int newSize = count | 0X7F;
       unsigned char *newCells = malloc(ARRAY_SIZE(newCells, newSize));
 
       if (!newCells) {
         logMallocError();
-        bcd->table->cache.output.count = 0;
+        entry->output.count = 0;
         goto outputDone;
       }
 
-      if (bcd->table->cache.output.cells) free(bcd->table->cache.output.cells);
-      bcd->table->cache.output.cells = newCells;
-      bcd->table->cache.output.size = newSize;
+      bcd->table->statistics.bufferAllocations += 1;
+      if (entry->output.cells) free(entry->output.cells);
+      entry->output.cells = newCells;
+      entry->output.size = newSize;
     }
 
-    memcpy(bcd->table->cache.output.cells, bcd->output.begin, count);
-    bcd->table->cache.output.count = count;
-    bcd->table->cache.output.maximum = getOutputCount(bcd);
+    memcpy(entry->output.cells, bcd->output.begin, count);
+    entry->output.count = count;
+    entry->output.maximum = getOutputCount(bcd);
   }
 outputDone:
 
   if (bcd->input.offsets) {
     unsigned int count = getInputCount(bcd);
 
-    if (count > bcd->table->cache.offsets.size) {
+    if (count > entry->offsets.size) {
       unsigned int newSize = count | 0X7F;
       int *newArray = malloc(ARRAY_SIZE(newArray, newSize));
 
       if (!newArray) {
         logMallocError();
-        bcd->table->cache.offsets.count = 0;
+        entry->offsets.count = 0;
         goto offsetsDone;
       }
 
-      if (bcd->table->cache.offsets.array) free(bcd->table->cache.offsets.array);
-      bcd->table->cache.offsets.array = newArray;
-      bcd->table->cache.offsets.size = newSize;
+      bcd->table->statistics.bufferAllocations += 1;
+      if (entry->offsets.array) free(entry->offsets.array);
+      entry->offsets.array = newArray;
+      entry->offsets.size = newSize;
     }
 
-    memcpy(bcd->table->cache.offsets.array, bcd->input.offsets, ARRAY_SIZE(bcd->input.offsets, count));
-    bcd->table->cache.offsets.count = count;
+    memcpy(entry->offsets.array, bcd->input.offsets, ARRAY_SIZE(bcd->input.offsets, count));
+    entry->offsets.count = count;
   } else {
-    bcd->table->cache.offsets.count = 0;
+    entry->offsets.count = 0;
   }
 offsetsDone:
 
-  bcd->table->cache.cursorOffset = makeCachedCursorOffset(bcd);
-  bcd->table->cache.expandCurrentWord = prefs.expandCurrentWord;
-  bcd->table->cache.capitalizationMode = prefs.capitalizationMode;
+  entry->cursorOffset = makeCachedCursorOffset(bcd);
+  entry->expandCurrentWord = prefs.expandCurrentWord;
+  entry->capitalizationMode = prefs.capitalizationMode;
 }
 
 void
@@ -266,20 +302,25 @@ contractText (
     }
   };
 
-  if (checkCache(&bcd)) {
-    bcd.input.current = bcd.input.begin + bcd.table->cache.input.consumed;
+  const ContractionCacheEntry *entry = checkCache(&bcd);
+
+  if (entry) {
+    contractionTable->statistics.cacheHits += 1;
+    bcd.input.current = bcd.input.begin + entry->input.consumed;
 
     if (bcd.input.offsets) {
-      memcpy(bcd.input.offsets, bcd.table->cache.offsets.array,
-             ARRAY_SIZE(bcd.input.offsets, bcd.table->cache.offsets.count));
+      memcpy(bcd.input.offsets, entry->offsets.array,
+             ARRAY_SIZE(bcd.input.offsets, entry->offsets.count));
     }
 
-    bcd.output.current = bcd.output.begin + bcd.table->cache.output.count;
-    memcpy(bcd.output.begin, bcd.table->cache.output.cells,
-           ARRAY_SIZE(bcd.output.begin, bcd.table->cache.output.count));
+    bcd.output.current = bcd.output.begin + entry->output.count;
+    memcpy(bcd.output.begin, entry->output.cells,
+           ARRAY_SIZE(bcd.output.begin, entry->output.count));
   } else {
     int contracted;
 
+    contractionTable->statistics.cacheMisses += 1;
+
     {
       size_t length = getInputCount(&bcd);
       wchar_t buffer[length];
@@ -373,8 +414,34 @@ contractText (
   *outputLength = getOutputConsumed(&bcd);
 }
 
-int
-replaceContractionTable (const char *directory, const char *name) {
+void
+getContractionTableStatistics (ContractionTable *table, ContractionTableStatistics *statistics) {
+  statistics->cacheHits = table->statistics.cacheHits;
+  statistics->cacheMisses = table->statistics.cacheMisses;
+  statistics->bufferAllocations = table->statistics.bufferAllocations;
+}
+
+void
+resetContractionTableStatistics (ContractionTable *table) {
+  memset(&table->statistics, 0, sizeof(table->statistics));
+}
+
+void
+clearContractionTableCache (ContractionTable *table) {
+  for (unsigned int index=0; index<CTB_CACHE_ENTRIES; index+=1) {
+    table->cache.entries[index].lastUsed = 0;
+  }
+
+  table->cache.clock = 0;
+}
+
+unsigned int
+getContractionTableCacheSize (void) {
+  return CTB_CACHE_ENTRIES;
+}
+
+ContractionTable *
+compileNamedContractionTable (const char *directory, const char *name) {
   ContractionTable *newTable = NULL;
 
   if (*name) {
@@ -393,14 +460,26 @@ replaceContractionTable (const char *directory, const char *name) {
     logMessage(LOG_ERR, "%s: %s", gettext("cannot access internal contraction table"), CONTRACTION_TABLE);
   }
 
-  if (newTable) {
-    ContractionTable *oldTable = contractionTable;
+  return newTable;
+}
+
+void
+installContractionTable (ContractionTable *newTable) {
+  ContractionTable *oldTable = contractionTable;
+
+  lockContractionTable();
+    contractionTable = newTable;
+  unlockContractionTable();
 
-    lockContractionTable();
-      contractionTable = newTable;
-    unlockContractionTable();
+  if (oldTable) destroyContractionTable(oldTable);
+}
 
-    if (oldTable) destroyContractionTable(oldTable);
+int
+replaceContractionTable (const char *directory, const char *name) {
+  ContractionTable *newTable = compileNamedContractionTable(directory, name);
+
+  if (newTable) {
+    installContractionTable(newTable);
     return 1;
   }
 
@@ -55,7 +55,11 @@ allocateDataItem (DataArea *area, DataOffset *offset, size_t size, size_t alignm
   size_t newUsed = newOffset + size;
 
   if (newUsed > area->size) {
-    size_t newSize = (newUsed | 0XFFF) + 1;
+    /* Grow geometrically so that building a large table doesn't copy its
+     * image over and over again. The slack is given back by shrinkDataArea.
+     */
+    size_t newSize = area->size? (area->size << 1): 0X1000;
+    if (newSize < newUsed) newSize = (newUsed | 0XFFF) + 1;
     unsigned char *newAddress;
 
     if (!(newAddress = realloc(area->address, newSize))) {
@@ -73,6 +77,19 @@ allocateDataItem (DataArea *area, DataOffset *offset, size_t size, size_t alignm
   return 1;
 }
 
+void
+shrinkDataArea (DataArea *area) {
+  if (area->used && (area->used < area->size)) {
+    unsigned char *newAddress;
+
+    /* if it can't be shrunk then it's still usable as is */
+    if ((newAddress = realloc(area->address, area->used))) {
+      area->address = newAddress;
+      area->size = area->used;
+    }
+  }
+}
+
 void *
 getDataItem (DataArea *area, DataOffset offset) {
   return area->address + offset;
@@ -184,8 +184,14 @@ isNumber (int *number, const wchar_t *characters, int length) {
   return 0;
 }
 
-static VariableNestingLevel *baseDataVariables = NULL;
-static VariableNestingLevel *currentDataVariables = NULL;
+#ifdef THREAD_LOCAL
+#define DATA_VARIABLES_STORAGE static THREAD_LOCAL
+#else /* THREAD_LOCAL */
+#define DATA_VARIABLES_STORAGE static
+#endif /* THREAD_LOCAL */
+
+DATA_VARIABLES_STORAGE VariableNestingLevel *baseDataVariables = NULL;
+DATA_VARIABLES_STORAGE VariableNestingLevel *currentDataVariables = NULL;
 
 static VariableNestingLevel *
 getBaseDataVariables (void) {
@@ -213,6 +219,19 @@ setBaseDataVariables (const VariableInitializer *initializers) {
   return setStringVariables(variables, initializers);
 }
 
+void
+releaseDataVariables (void) {
+  if (currentDataVariables) {
+    releaseVariableNestingLevel(currentDataVariables);
+    currentDataVariables = NULL;
+  }
+
+  if (baseDataVariables) {
+    releaseVariableNestingLevel(baseDataVariables);
+    baseDataVariables = NULL;
+  }
+}
+
 int
 setTableDataVariables (const char *tableExtension, const char *subtableExtension) {
   const VariableInitializer initializers[] = {
@@ -48,6 +48,7 @@ extern "C" {
 #define DEFAULT_BRAILLE_VARIANT bvComputer8
 #define DEFAULT_EXPAND_CURRENT_WORD 1
 #define DEFAULT_CAPITALIZATION_MODE CTB_CAP_SIGN
+#define DEFAULT_WRAP_CONTRACTED_LINE 0
 #define DEFAULT_BRAILLE_FIRMNESS BRL_FIRMNESS_MEDIUM
 
 #define DEFAULT_SHOW_SCREEN_CURSOR 1		/* 1 for yes, 0 for no */
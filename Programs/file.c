@@ -40,6 +40,11 @@
 #include <sys/file.h>
 #endif /* HAVE_SYS_FILE_H */
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <sys/mman.h>
+#define CAN_MAP_FILES
+#endif /* map files */
+
 #include "parameters.h"
 #include "log.h"
 #include "strfmt.h"
@@ -1019,6 +1024,78 @@ readLine (FILE *file, char **buffer, size_t *size, size_t *length) {
   return 0;
 }
 
+#ifdef CAN_MAP_FILES
+/* Scan the lines of a regular file directly within a private (copy-on-write)
+ * mapping of it, terminating each one in place, rather than copying them,
+ * piece by piece, into a growing buffer.
+ */
+static int
+processMappedLines (FILE *file, LineHandlerParameters *parameters, LineHandler handleLine, int *ok) {
+  int fd = fileno(file);
+  if (fd == -1) return 0;
+
+  struct stat status;
+  if (fstat(fd, &status) == -1) return 0;
+  if (!S_ISREG(status.st_mode)) return 0;
+
+  off_t start = ftello(file);
+  if (start == -1) return 0;
+  if (start >= status.st_size) return 0;
+
+  size_t size = status.st_size;
+  if (size != status.st_size) return 0;
+
+  char *address = mmap(NULL, size, (PROT_READ | PROT_WRITE), MAP_PRIVATE, fd, 0);
+  if (address == MAP_FAILED) return 0;
+
+  const char *end = address + size;
+  char *line = address + start;
+  char *lastLine = NULL;
+
+  while (line < end) {
+    char *next;
+    size_t length;
+
+    {
+      char *newline = memchr(line, '\n', (end - line));
+
+      if (newline) {
+        next = newline + 1;
+        length = newline - line;
+        if (length && (line[length-1] == '\r')) length -= 1;
+        line[length] = 0;
+      } else {
+        /* there's no room within the mapping for the terminating NUL */
+        next = (char *)end;
+        length = end - line;
+
+        if (!(lastLine = malloc(length + 1))) {
+          logMallocError();
+          *ok = 0;
+          break;
+        }
+
+        memcpy(lastLine, line, length);
+        lastLine[length] = 0;
+        line = lastLine;
+      }
+    }
+
+    parameters->line.number += 1;
+    parameters->line.text = line;
+    parameters->line.length = length;
+
+    line = next;
+    if (!handleLine(parameters)) break;
+  }
+
+  if (lastLine) free(lastLine);
+  if (fseeko(file, (line - address), SEEK_SET) == -1) logSystemError("fseeko");
+  if (munmap(address, size) == -1) logSystemError("munmap");
+  return 1;
+}
+#endif /* CAN_MAP_FILES */
+
 /* Process each line of an input text file safely.
  * This routine handles the actual reading of the file,
  * insuring that the input buffer is always big enough,
@@ -1027,9 +1104,6 @@ readLine (FILE *file, char **buffer, size_t *size, size_t *length) {
  */
 int
 processLines (FILE *file, LineHandler handleLine, void *data) {
-  char *buffer = NULL;
-  size_t bufferSize = 0;
-
   LineHandlerParameters parameters = {
     .data = data,
 
@@ -1038,6 +1112,19 @@ processLines (FILE *file, LineHandler handleLine, void *data) {
     },
   };
 
+#ifdef CAN_MAP_FILES
+  {
+    int ok = 1;
+
+    if (processMappedLines(file, &parameters, handleLine, &ok)) {
+      return ok && !ferror(file);
+    }
+  }
+#endif /* CAN_MAP_FILES */
+
+  char *buffer = NULL;
+  size_t bufferSize = 0;
+
   while (1) {
     parameters.line.number += 1;
     if (!readLine(file, &buffer, &bufferSize, &parameters.line.length)) break;
@@ -24,6 +24,7 @@
 #include "log.h"
 #include "file.h"
 #include "datafile.h"
+#include "memusage.h"
 #include "cmd.h"
 #include "brl_cmds.h"
 #include "ktb.h"
@@ -1562,6 +1563,25 @@ prepareKeyBindings (KeyContext *ctx) {
   return 1;
 }
 
+static size_t
+getKeyTableMemoryUsage (const KeyTable *table) {
+  size_t size = sizeof(*table);
+
+  size += ARRAY_SIZE(table->notes.table, table->notes.size);
+  size += ARRAY_SIZE(table->keyNames.table, table->keyNames.count);
+  size += ARRAY_SIZE(table->keyContexts.table, table->keyContexts.count);
+
+  for (unsigned int context=0; context<table->keyContexts.count; context+=1) {
+    const KeyContext *ctx = &table->keyContexts.table[context];
+
+    size += ARRAY_SIZE(ctx->keyBindings.table, ctx->keyBindings.size);
+    size += ARRAY_SIZE(ctx->hotkeys.table, ctx->hotkeys.size);
+    size += ARRAY_SIZE(ctx->mappedKeys.table, ctx->mappedKeys.size);
+  }
+
+  return size;
+}
+
 int
 finishKeyTable (KeyTableData *ktd) {
   for (unsigned int context=0; context<ktd->table->keyContexts.count; context+=1) {
@@ -1571,6 +1591,9 @@ finishKeyTable (KeyTableData *ktd) {
 
   qsort(ktd->table->keyNames.table, ktd->table->keyNames.count, sizeof(*ktd->table->keyNames.table), sortKeyValues);
   resetKeyTable(ktd->table);
+
+  ktd->table->memoryUsage = getKeyTableMemoryUsage(ktd->table);
+  addMemoryUsage(MEMORY_TABLES, ktd->table->memoryUsage);
   return 1;
 }
 
@@ -1667,6 +1690,8 @@ compileKeyTable (const char *name, KEY_NAME_TABLES_REFERENCE keys) {
       ktd.table->options.logKeyEventsFlag = NULL;
       ktd.table->options.keyboardEnabledFlag = NULL;
 
+      ktd.table->memoryUsage = 0;
+
       if (defineInitialKeyContexts(&ktd)) {
         if (allocateKeyNameTable(&ktd, keys)) {
           if (allocateCommandTable(&ktd)) {
@@ -1698,6 +1723,7 @@ compileKeyTable (const char *name, KEY_NAME_TABLES_REFERENCE keys) {
 
 void
 destroyKeyTable (KeyTable *table) {
+  subtractMemoryUsage(MEMORY_TABLES, table->memoryUsage);
   resetLongPressData(table);
   setKeyAutoreleaseTime(table, 0);
 
@@ -173,6 +173,8 @@ struct KeyTableStruct {
     const unsigned char *logKeyEventsFlag;
     const unsigned char *keyboardEnabledFlag;
   } options;
+
+  size_t memoryUsage;
 };
 
 extern void copyKeyValues (KeyValue *target, const KeyValue *source, unsigned int count);
@@ -40,6 +40,9 @@
 #include "stdiox.h"
 #include "thread.h"
 
+#undef logMessage
+#undef logBytes
+
 const char logCategoryName_all[] = "all";
 const char logCategoryPrefix_disable = '-';
 
@@ -166,6 +169,12 @@ static const LogCategoryEntry logCategoryTable[LOG_CATEGORY_COUNT] = {
     .title = strtext("Screen Driver Events"),
     .prefix = "screen driver"
   },
+
+  [LOG_CATEGORY_INDEX(MEMORY_USAGE)] = {
+    .name = "memory",
+    .title = strtext("Memory Usage"),
+    .prefix = "memory"
+  },
 };
 
 unsigned char categoryLogLevel = LOG_WARNING;
@@ -276,9 +285,372 @@ popLogPrefix (void) {
   return popLogEntry(&logPrefixStack);
 }
 
+static void
+writeLogFileRecord (const TimeValue *time, const char *thread, const char *record) {
+  {
+    char buffer[0X20];
+    size_t length = formatSeconds(buffer, sizeof(buffer), "%Y-%m-%d@%H:%M:%S", time->seconds);
+    unsigned int milliseconds = time->nanoseconds / NSECS_PER_MSEC;
+
+    fprintf(logFile, "%.*s.%03u ", (int)length, buffer, milliseconds);
+  }
+
+  if (*thread) fprintf(logFile, "[%s] ", thread);
+  fputs(record, logFile);
+  fputc('\n', logFile);
+}
+
+static void
+getLogThreadName (char *buffer, size_t size) {
+  size_t length = formatThreadName(buffer, size);
+
+  if (length >= size) length = size - 1;
+  buffer[length] = 0;
+}
+
+#if defined(GOT_PTHREADS) && defined(HAVE_SYNC_COMPARE_AND_SWAP)
+#define LOG_WRITER_THREAD
+
+#include <signal.h>
+
+/* Records destined for the log file are queued, by whichever thread logs
+ * them, into a bounded ring which is drained by a background writer thread.
+ * Claiming a slot is lock-free: a producer advances the tail with a
+ * compare-and-swap, fills the slot, and then publishes it by bumping the
+ * slot's turn counter. The writer wakes up periodically (or when the ring
+ * is getting full) and writes everything that's been published in a single
+ * batch. If the ring is full then the record is dropped and counted.
+ *
+ * The producer only copies the already formatted text (short records go
+ * straight into the slot) and notes the time - the time stamp and the final
+ * record layout are formatted by the writer. The thread name is cached per
+ * thread (see formatThreadName) so it doesn't cost a system call either.
+ *
+ * The ring is allocated when the writer is first started so that programs
+ * which never log to a file don't carry it around.
+ */
+
+#define LOG_RING_SIZE 0X400
+#define LOG_WRITER_INTERVAL 100
+#define LOG_RING_TEXT_SIZE 0X100
+
+typedef struct {
+  volatile unsigned long turn;
+  TimeValue time;
+  char *record;
+  char thread[0X20];
+  char text[LOG_RING_TEXT_SIZE];
+} LogRingSlot;
+
+static LogRingSlot *volatile logRingSlots = NULL;
+static volatile unsigned long logRingTail = 0;
+static unsigned long logRingHead = 0;
+
+static volatile unsigned long droppedLogRecordCount = 0;
+static unsigned long reportedLogRecordCount = 0;
+
+typedef enum {
+  LWS_STOPPED,
+  LWS_STARTING,
+  LWS_RUNNING,
+  LWS_STOPPING,
+  LWS_FAILED
+} LogWriterState;
+
+static volatile LogWriterState logWriterState = LWS_STOPPED;
+static volatile unsigned char logWriterWaiting = 0;
+static pthread_t logWriterThread;
+
+static pthread_mutex_t logWriterMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t logWriterCondition = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t logRingConsumerLock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline unsigned long
+getLogRingTurn (unsigned long position) {
+  return (position / LOG_RING_SIZE) * 2;
+}
+
+static inline LogRingSlot *
+getLogRingSlot (unsigned long position) {
+  return &logRingSlots[position % LOG_RING_SIZE];
+}
+
+static int
+allocateLogRing (void) {
+  if (logRingSlots) return 1;
+
+  /* don't log the failure - we're part of logging */
+  LogRingSlot *slots = calloc(LOG_RING_SIZE, sizeof(*slots));
+  if (!slots) return 0;
+
+  __sync_synchronize();
+  if (__sync_val_compare_and_swap(&logRingSlots, NULL, slots)) free(slots);
+  return 1;
+}
+
+static void
+awakenLogWriter (void) {
+  if (logWriterWaiting) pthread_cond_signal(&logWriterCondition);
+}
+
+static void
+enqueueLogRecord (const char *record) {
+  size_t size = strlen(record) + 1;
+  char *copy = NULL;
+
+  /* long records are rare - only they need to be allocated */
+  if (size > LOG_RING_TEXT_SIZE) {
+    if (!(copy = strdup(record))) goto drop;
+  }
+
+  {
+    unsigned long position = logRingTail;
+    LogRingSlot *slot;
+    unsigned long turn;
+
+    while (1) {
+      slot = getLogRingSlot(position);
+      turn = getLogRingTurn(position);
+
+      __sync_synchronize();
+      long int difference = slot->turn - turn;
+
+      if (difference == 0) {
+        unsigned long tail = __sync_val_compare_and_swap(&logRingTail, position, position+1);
+        if (tail == position) break;
+        position = tail;
+      } else if (difference < 0) {
+        /* the slot still holds a record from the previous lap */
+        goto drop;
+      } else {
+        position = logRingTail;
+      }
+    }
+
+    getCurrentTime(&slot->time);
+    getLogThreadName(slot->thread, sizeof(slot->thread));
+
+    if (copy) {
+      slot->record = copy;
+    } else {
+      memcpy(slot->text, record, size);
+      slot->record = slot->text;
+    }
+
+    __sync_synchronize();
+    slot->turn = turn + 1;
+
+    if (!((position + 1) % (LOG_RING_SIZE / 2))) awakenLogWriter();
+    return;
+  }
+
+drop:
+  if (copy) free(copy);
+  __sync_fetch_and_add(&droppedLogRecordCount, 1);
+}
+
+static void
+drainLogRing (void) {
+  unsigned int count = 0;
+
+  lockStream(logFile);
+
+  while (logRingSlots) {
+    LogRingSlot *slot = getLogRingSlot(logRingHead);
+    unsigned long turn = getLogRingTurn(logRingHead);
+
+    __sync_synchronize();
+    if (slot->turn != (turn + 1)) break;
+
+    writeLogFileRecord(&slot->time, slot->thread, slot->record);
+    if (slot->record != slot->text) free(slot->record);
+    slot->record = NULL;
+
+    __sync_synchronize();
+    slot->turn = turn + 2;
+
+    logRingHead += 1;
+    count += 1;
+  }
+
+  {
+    unsigned long dropped = droppedLogRecordCount;
+
+    if (dropped != reportedLogRecordCount) {
+      TimeValue now;
+      char record[0X40];
+
+      getCurrentTime(&now);
+      snprintf(record, sizeof(record), "log records dropped: %lu",
+               dropped - reportedLogRecordCount);
+
+      writeLogFileRecord(&now, "", record);
+      reportedLogRecordCount = dropped;
+      count += 1;
+    }
+  }
+
+  if (count) flushStream(logFile);
+  unlockStream(logFile);
+}
+
+static void
+flushLogRing (void) {
+  pthread_mutex_lock(&logRingConsumerLock);
+  drainLogRing();
+  pthread_mutex_unlock(&logRingConsumerLock);
+}
+
+static void *
+runLogWriter (void *argument) {
+  {
+    sigset_t signals;
+
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  }
+
+  setThreadName("log-writer");
+  pthread_mutex_lock(&logWriterMutex);
+
+  while (logWriterState == LWS_RUNNING) {
+    pthread_mutex_unlock(&logWriterMutex);
+    flushLogRing();
+    pthread_mutex_lock(&logWriterMutex);
+    if (logWriterState != LWS_RUNNING) break;
+
+    {
+      TimeValue time;
+      getCurrentTime(&time);
+      adjustTimeValue(&time, LOG_WRITER_INTERVAL);
+
+      const struct timespec timeout = {
+        .tv_sec = time.seconds,
+        .tv_nsec = time.nanoseconds
+      };
+
+      logWriterWaiting = 1;
+      pthread_cond_timedwait(&logWriterCondition, &logWriterMutex, &timeout);
+      logWriterWaiting = 0;
+    }
+  }
+
+  pthread_mutex_unlock(&logWriterMutex);
+  return NULL;
+}
+
+static int
+startLogWriter (void) {
+  while (1) {
+    switch (logWriterState) {
+      case LWS_RUNNING:
+      case LWS_STARTING:
+        return 1;
+
+      case LWS_STOPPED:
+        /* the ring must exist before any producer can see the writer starting */
+        if (!allocateLogRing()) return 0;
+        if (__sync_val_compare_and_swap(&logWriterState, LWS_STOPPED, LWS_STARTING) != LWS_STOPPED) continue;
+
+        {
+          int error = pthread_create(&logWriterThread, NULL, runLogWriter, NULL);
+
+          logWriterState = error? LWS_FAILED: LWS_RUNNING;
+          return !error;
+        }
+
+      default:
+        return 0;
+    }
+  }
+}
+
+static void
+stopLogWriter (void) {
+  if (logWriterState == LWS_RUNNING) {
+    pthread_mutex_lock(&logWriterMutex);
+    logWriterState = LWS_STOPPING;
+    pthread_cond_signal(&logWriterCondition);
+    pthread_mutex_unlock(&logWriterMutex);
+
+    pthread_join(logWriterThread, NULL);
+  }
+
+  flushLogRing();
+  logWriterState = LWS_STOPPED;
+
+  pthread_mutex_lock(&logRingConsumerLock);
+
+  {
+    /* those dropped before the final flush have already been reported */
+    unsigned long dropped = droppedLogRecordCount;
+
+    if (dropped != reportedLogRecordCount) {
+      TimeValue now;
+      char record[0X40];
+
+      getCurrentTime(&now);
+      snprintf(record, sizeof(record), "log writer stopped: %lu records dropped",
+               dropped - reportedLogRecordCount);
+
+      lockStream(logFile);
+      writeLogFileRecord(&now, "", record);
+      flushStream(logFile);
+      unlockStream(logFile);
+      reportedLogRecordCount = dropped;
+    }
+  }
+
+  pthread_mutex_unlock(&logRingConsumerLock);
+}
+
+/* Both locks are held across the fork so that the child doesn't inherit
+ * either of them in a locked state from a thread which no longer exists.
+ */
+static void
+prepareLogWriterFork (void) {
+  pthread_mutex_lock(&logWriterMutex);
+  pthread_mutex_lock(&logRingConsumerLock);
+  if (logFile) drainLogRing();
+}
+
+static void
+resumeLogWriterParent (void) {
+  pthread_mutex_unlock(&logRingConsumerLock);
+  pthread_mutex_unlock(&logWriterMutex);
+}
+
+static void
+resumeLogWriterChild (void) {
+  pthread_mutex_unlock(&logRingConsumerLock);
+  pthread_mutex_unlock(&logWriterMutex);
+
+  /* the writer may have been waiting on the condition when we forked */
+  pthread_cond_init(&logWriterCondition, NULL);
+  logWriterWaiting = 0;
+
+  /* the writer thread doesn't survive the fork - restart it on demand */
+  if (logWriterState == LWS_RUNNING) logWriterState = LWS_STOPPED;
+}
+
+static void
+registerLogWriterFork (void) {
+  static unsigned char registered = 0;
+
+  if (!registered) {
+    pthread_atfork(prepareLogWriterFork, resumeLogWriterParent, resumeLogWriterChild);
+    registered = 1;
+  }
+}
+#endif /* LOG_WRITER_THREAD */
+
 void
 closeLogFile (void) {
   if (logFile) {
+#ifdef LOG_WRITER_THREAD
+    stopLogWriter();
+#endif /* LOG_WRITER_THREAD */
+
     fclose(logFile);
     logFile = NULL;
   }
@@ -288,38 +660,50 @@ void
 openLogFile (const char *path) {
   closeLogFile();
   logFile = fopen(path, "w");
-  if (logFile) writeUtf8ByteOrderMark(logFile);
+
+  if (logFile) {
+    writeUtf8ByteOrderMark(logFile);
+
+#ifdef LOG_WRITER_THREAD
+    registerLogWriterFork();
+#endif /* LOG_WRITER_THREAD */
+  }
 }
 
 static void
-writeLogRecord (const char *record) {
+writeLogRecord (int level, const char *record) {
   if (logFile) {
-    lockStream(logFile);
+#ifdef LOG_WRITER_THREAD
+    /* Serious problems are written immediately (after whatever's still
+     * queued) so that they're on disk should we be about to crash.
+     */
+    if (level > LOG_ERR) {
+      if (startLogWriter()) {
+        enqueueLogRecord(record);
+        return;
+      }
+    }
+
+    pthread_mutex_lock(&logRingConsumerLock);
+    drainLogRing();
+#endif /* LOG_WRITER_THREAD */
 
     {
       TimeValue now;
-      char buffer[0X20];
-      size_t length;
-      unsigned int milliseconds;
+      char thread[0X40];
 
       getCurrentTime(&now);
-      length = formatSeconds(buffer, sizeof(buffer), "%Y-%m-%d@%H:%M:%S", now.seconds);
-      milliseconds = now.nanoseconds / NSECS_PER_MSEC;
-
-      fprintf(logFile, "%.*s.%03u ", (int)length, buffer, milliseconds);
-    }
-
-    {
-      char name[0X40];
-      size_t length = formatThreadName(name, sizeof(name));
+      getLogThreadName(thread, sizeof(thread));
 
-      if (length) fprintf(logFile, "[%s] ", name);
+      lockStream(logFile);
+      writeLogFileRecord(&now, thread, record);
+      flushStream(logFile);
+      unlockStream(logFile);
     }
 
-    fputs(record, logFile);
-    fputc('\n', logFile);
-    flushStream(logFile);
-    unlockStream(logFile);
+#ifdef LOG_WRITER_THREAD
+    pthread_mutex_unlock(&logRingConsumerLock);
+#endif /* LOG_WRITER_THREAD */
   }
 }
 
@@ -382,6 +766,7 @@ logData (int level, LogDataFormatter *formatLogData, const void *data) {
   if (category) {
     category -= 1;
 
+    if (LOG_EXCLUDED_CATEGORIES & (1UL << category)) return 0;
     if (!logCategoryFlags[category]) return 0;
     if (!level) level = categoryLogLevel;
 
@@ -406,7 +791,7 @@ logData (int level, LogDataFormatter *formatLogData, const void *data) {
   STR_END;
 
   if (write) {
-    writeLogRecord(record);
+    writeLogRecord(level, record);
 
 #if defined(WINDOWS)
     if (windowsEventLog != INVALID_HANDLE_VALUE) {
@@ -23,6 +23,7 @@
 #include "log.h"
 #include "log_history.h"
 #include "timing.h"
+#include "memusage.h"
 
 struct LogEntryStruct {
   struct LogEntryStruct *previous;
@@ -96,6 +97,51 @@ popLogEntry (LogEntry **head) {
   return 1;
 }
 
+/* The log message history is a bounded list, from the oldest message to
+ * the newest: the oldest messages are evicted (in constant time) once either
+ * the entry limit or the byte limit is exceeded. Recent messages are also
+ * hashed so that a repeat of any of them - not only of the newest - is
+ * squashed into the existing entry, which is then relinked (also in constant
+ * time) as the newest one.
+ */
+
+typedef struct LogMessageStruct LogMessage;
+
+struct LogMessageStruct {
+  LogMessage *older;
+  LogMessage *newer;
+
+  LogMessage *nextInBucket;
+  LogMessage **previousInBucket;
+
+  unsigned long sequence;
+  unsigned int hash;
+  size_t size;
+
+  LogEntry entry; /* must be last - its text is variable length */
+};
+
+#define LOG_MESSAGE_BUCKET_COUNT 0X40
+
+static struct {
+  LogMessage *oldest;
+  LogMessage *newest;
+  unsigned int count;
+  unsigned int entryLimit;
+
+  size_t bytes;
+  size_t byteLimit;
+
+  unsigned long sequence;
+
+  LogMessage *buckets[LOG_MESSAGE_BUCKET_COUNT];
+} logMessageHistory = {
+  .oldest = NULL,
+  .newest = NULL,
+  .entryLimit = LOG_MESSAGE_HISTORY_ENTRY_LIMIT,
+  .byteLimit = LOG_MESSAGE_HISTORY_BYTE_LIMIT
+};
+
 static CriticalSectionLock logMessageLock = CRITICAL_SECTION_LOCK_INITIALIZER;
 
 static void
@@ -108,20 +154,174 @@ unlockLogMessages (void) {
   leaveCriticalSection(&logMessageLock);
 }
 
-static LogEntry *logMessageStack = NULL;
+static unsigned int
+hashLogMessage (const char *text) {
+  unsigned int hash = 2166136261U;
 
-const LogEntry *
-getNewestLogMessage (int freeze) {
-  lockLogMessages();
-  LogEntry *message = logMessageStack;
-  if (freeze && message) message->noSquash = 1;
-  unlockLogMessages();
-  return message;
+  while (*text) {
+    hash ^= (unsigned char)*text++;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+static void
+linkNewestLogMessage (LogMessage *message) {
+  message->newer = NULL;
+
+  if ((message->older = logMessageHistory.newest)) {
+    message->older->newer = message;
+  } else {
+    logMessageHistory.oldest = message;
+  }
+
+  logMessageHistory.newest = message;
+}
+
+static void
+unlinkLogMessage (LogMessage *message) {
+  if (message->older) {
+    message->older->newer = message->newer;
+  } else {
+    logMessageHistory.oldest = message->newer;
+  }
+
+  if (message->newer) {
+    message->newer->older = message->older;
+  } else {
+    logMessageHistory.newest = message->older;
+  }
+}
+
+static void
+removeOldestLogMessage (void) {
+  LogMessage *message = logMessageHistory.oldest;
+  unlinkLogMessage(message);
+
+  if ((*message->previousInBucket = message->nextInBucket)) {
+    message->nextInBucket->previousInBucket = message->previousInBucket;
+  }
+
+  logMessageHistory.bytes -= message->size;
+  subtractMemoryUsage(MEMORY_LOG_HISTORY, message->size);
+  free(message);
+  logMessageHistory.count -= 1;
+}
+
+static void
+trimLogMessages (unsigned int entries, size_t bytes) {
+  while (logMessageHistory.count) {
+    if ((logMessageHistory.count + entries) <= logMessageHistory.entryLimit) {
+      if ((logMessageHistory.bytes + bytes) <= logMessageHistory.byteLimit) {
+        break;
+      }
+    }
+
+    removeOldestLogMessage();
+  }
+}
+
+static LogMessage *
+findLogMessage (const char *text, unsigned int hash) {
+  LogMessage *message = logMessageHistory.buckets[hash % LOG_MESSAGE_BUCKET_COUNT];
+
+  while (message) {
+    if (message->hash == hash) {
+      if (strcmp(message->entry.text, text) == 0) return message;
+    }
+
+    message = message->nextInBucket;
+  }
+
+  return NULL;
+}
+
+static int
+addLogMessage (const char *text) {
+  unsigned int hash = hashLogMessage(text);
+  LogMessage *message = findLogMessage(text, hash);
+
+  if (message) {
+    message->entry.count += 1;
+    message->sequence = ++logMessageHistory.sequence;
+
+    if (message != logMessageHistory.newest) {
+      unlinkLogMessage(message);
+      linkNewestLogMessage(message);
+    }
+  } else {
+    const size_t size = sizeof(*message) + strlen(text) + 1;
+    if (size > logMessageHistory.byteLimit) return 0;
+    trimLogMessages(1, size);
+
+    if (!(message = malloc(size))) return 0;
+    memset(message, 0, sizeof(*message));
+
+    message->sequence = ++logMessageHistory.sequence;
+    message->hash = hash;
+    message->size = size;
+
+    message->entry.count = 1;
+    strcpy(message->entry.text, text);
+
+    {
+      LogMessage **bucket = &logMessageHistory.buckets[hash % LOG_MESSAGE_BUCKET_COUNT];
+
+      if ((message->nextInBucket = *bucket)) {
+        message->nextInBucket->previousInBucket = &message->nextInBucket;
+      }
+
+      message->previousInBucket = bucket;
+      *bucket = message;
+    }
+
+    linkNewestLogMessage(message);
+    logMessageHistory.count += 1;
+    logMessageHistory.bytes += size;
+    addMemoryUsage(MEMORY_LOG_HISTORY, size);
+  }
+
+  getCurrentTime(&message->entry.time);
+  return 1;
 }
 
 void
 pushLogMessage (const char *message) {
   lockLogMessages();
-  pushLogEntry(&logMessageStack, message, (LPO_NOLOG | LPO_SQUASH));
+  addLogMessage(message);
+  unlockLogMessages();
+}
+
+int
+processNewLogMessages (unsigned long *sequence, LogEntryHandler *handleLogEntry, void *data) {
+  int ok = 1;
+  lockLogMessages();
+
+  for (const LogMessage *message=logMessageHistory.oldest; message; message=message->newer) {
+    if (message->sequence > *sequence) {
+      if (!handleLogEntry(&message->entry, data)) {
+        ok = 0;
+        break;
+      }
+
+      *sequence = message->sequence;
+    }
+  }
+
+  unlockLogMessages();
+  return ok;
+}
+
+int
+setLogMessageHistoryLimits (unsigned int entries, size_t bytes) {
+  if (!entries) return 0;
+  lockLogMessages();
+
+  logMessageHistory.entryLimit = entries;
+  logMessageHistory.byteLimit = bytes;
+  trimLogMessages(0, 0);
+
   unlockLogMessages();
+  return 1;
 }
@@ -0,0 +1,117 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "timing.h"
+
+static char *opt_iterations;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "iterations",
+    .letter = 'i',
+    .argument = "count",
+    .setting.string = &opt_iterations,
+    .internal.setting = "10000000",
+    .description = "the number of times to log each message"
+  },
+END_OPTION_TABLE
+
+/* Each of these logs a message in a category which isn't enabled, which is
+ * by far the most common case at run-time. Whether the inline call measures
+ * a category which is merely disabled or one which has been compiled out
+ * depends on how this build was configured - use
+ * --with-excluded-log-categories=update for the latter.
+ */
+#define BENCHMARK_LOG_LEVEL LOG_CATEGORY(UPDATE_EVENTS)
+
+typedef int LogCallFunction (unsigned int iteration);
+
+static int
+logOutOfLine (unsigned int iteration) {
+  /* how every call site was compiled before the category test was inlined */
+  return (logMessage)(BENCHMARK_LOG_LEVEL, "iteration %u", iteration);
+}
+
+static int
+logInline (unsigned int iteration) {
+  return logMessage(BENCHMARK_LOG_LEVEL, "iteration %u", iteration);
+}
+
+static void
+benchmarkLogCalls (const char *label, LogCallFunction *log, int iterations) {
+  unsigned long int logged = 0;
+
+  TimeValue start;
+  getMonotonicTime(&start);
+
+  for (int iteration=0; iteration<iterations; iteration+=1) {
+    if (log(iteration)) logged += 1;
+  }
+
+  long int elapsed = getMonotonicElapsed(&start);
+  unsigned long int rate = elapsed? (((unsigned long int)iterations * MSECS_PER_SEC) / elapsed): 0;
+
+  printf(
+    "%s: %d calls (%lu logged) in %ldms: %lu/s\n",
+    label, iterations, logged, elapsed, rate
+  );
+}
+
+int
+main (int argc, char *argv[]) {
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "logtest"
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  int iterations;
+
+  {
+    static const int minimum = 1;
+
+    if (!validateInteger(&iterations, opt_iterations, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid iteration count: %s", opt_iterations);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
+  if (argc) {
+    logMessage(LOG_ERR, "too many parameters");
+    return PROG_EXIT_SYNTAX;
+  }
+
+  benchmarkLogCalls("out-of-line", logOutOfLine, iterations);
+
+  benchmarkLogCalls(
+    ((LOG_EXCLUDED_CATEGORIES & LOG_CATEGORY_BIT(UPDATE_EVENTS))? "excluded": "inline"),
+    logInline, iterations
+  );
+
+  return PROG_EXIT_SUCCESS;
+}
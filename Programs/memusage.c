@@ -0,0 +1,150 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include "log.h"
+#include "strfmt.h"
+#include "memusage.h"
+
+/* The counters are updated from several threads (the table compilers, the
+ * BrlAPI server, the log writer) so, when possible, they're maintained
+ * atomically. The peak is only a high-water mark and a lost update merely
+ * understates it a little.
+ */
+
+typedef struct {
+  const char *name;
+  size_t current;
+  size_t peak;
+} MemoryUsageEntry;
+
+static MemoryUsageEntry memoryUsageTable[MEMORY_COMPONENT_COUNT] = {
+  [MEMORY_TABLES] = {
+    .name = "tables"
+  },
+
+  [MEMORY_SCREEN_CACHES] = {
+    .name = "screen caches"
+  },
+
+  [MEMORY_API_CONNECTIONS] = {
+    .name = "api connections"
+  },
+
+  [MEMORY_QUEUES] = {
+    .name = "queues"
+  },
+
+  [MEMORY_LOG_HISTORY] = {
+    .name = "log history"
+  },
+
+  [MEMORY_CLIPBOARD] = {
+    .name = "clipboard"
+  },
+};
+
+const char *
+getMemoryComponentName (MemoryComponent component) {
+  if (component >= MEMORY_COMPONENT_COUNT) return NULL;
+  return memoryUsageTable[component].name;
+}
+
+void
+addMemoryUsage (MemoryComponent component, size_t size) {
+  MemoryUsageEntry *entry = &memoryUsageTable[component];
+
+#ifdef HAVE_SYNC_ADD_AND_FETCH
+  size_t current = __sync_add_and_fetch(&entry->current, size);
+#else /* HAVE_SYNC_ADD_AND_FETCH */
+  size_t current = entry->current += size;
+#endif /* HAVE_SYNC_ADD_AND_FETCH */
+
+#ifdef HAVE_SYNC_COMPARE_AND_SWAP
+  size_t peak = 0; /* the first swap fetches the actual peak */
+
+  while (current > peak) {
+    size_t previous = __sync_val_compare_and_swap(&entry->peak, peak, current);
+    if (previous == peak) break;
+    peak = previous;
+  }
+#else /* HAVE_SYNC_COMPARE_AND_SWAP */
+  if (current > entry->peak) entry->peak = current;
+#endif /* HAVE_SYNC_COMPARE_AND_SWAP */
+}
+
+void
+subtractMemoryUsage (MemoryComponent component, size_t size) {
+  MemoryUsageEntry *entry = &memoryUsageTable[component];
+
+#ifdef HAVE_SYNC_ADD_AND_FETCH
+  __sync_sub_and_fetch(&entry->current, size);
+#else /* HAVE_SYNC_ADD_AND_FETCH */
+  entry->current -= size;
+#endif /* HAVE_SYNC_ADD_AND_FETCH */
+}
+
+void
+updateMemoryUsage (MemoryComponent component, size_t *accounted, size_t size) {
+  if (size > *accounted) {
+    addMemoryUsage(component, (size - *accounted));
+  } else if (size < *accounted) {
+    subtractMemoryUsage(component, (*accounted - size));
+  }
+
+  *accounted = size;
+}
+
+size_t
+getMemoryUsage (MemoryComponent component) {
+  return memoryUsageTable[component].current;
+}
+
+size_t
+getMemoryUsagePeak (MemoryComponent component) {
+  return memoryUsageTable[component].peak;
+}
+
+void
+logMemoryUsage (const char *reason) {
+  if (!testLogLevel(LOG_CATEGORY(MEMORY_USAGE))) return;
+
+  char log[0X100];
+  STR_BEGIN(log, sizeof(log));
+  STR_PRINTF("%s:", reason);
+
+  {
+    size_t total = 0;
+
+    for (MemoryComponent component=0; component<MEMORY_COMPONENT_COUNT; component+=1) {
+      const MemoryUsageEntry *entry = &memoryUsageTable[component];
+      total += entry->current;
+
+      STR_PRINTF(
+        " %s=%" PRIsize "/%" PRIsize,
+        entry->name, entry->current, entry->peak
+      );
+    }
+
+    STR_PRINTF(" total=%" PRIsize, total);
+  }
+
+  STR_END;
+  logMessage(LOG_CATEGORY(MEMORY_USAGE), "%s", log);
+}
@@ -206,6 +206,20 @@ destroyMenu (Menu *menu) {
   }
 }
 
+void
+removeMenuItems (Menu *menu, unsigned int index) {
+  while (menu->items.count > index) {
+    MenuItem *item = &menu->items.array[--menu->items.count];
+
+    if (item == menu->activeItem) menu->activeItem = NULL;
+    endMenuItem(item, 1);
+  }
+
+  if (menu->items.index >= menu->items.count) {
+    menu->items.index = menu->items.count? (menu->items.count - 1): 0;
+  }
+}
+
 unsigned int
 getMenuNumber (const Menu *menu) {
   return menu->menuNumber;
@@ -376,6 +390,11 @@ newTextMenuItem (Menu *menu, const MenuString *name, const char *text) {
   return item;
 }
 
+void
+setMenuItemText (MenuItem *item, const char *text) {
+  if (item->methods == &menuItemMethods_text) item->data.text = text;
+}
+
 static const char *
 getValue_numeric (const MenuItem *item) {
   Menu *menu = item->menu;
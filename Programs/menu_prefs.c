@@ -478,6 +478,11 @@ testContractedBraille (void) {
   return isContractedBraille();
 }
 
+static int
+testMultipleContractedRows (void) {
+  return isContractedBraille() && (brl.textRows > 1);
+}
+
 static int
 changedContractedBraille (const MenuItem *item, unsigned char setting UNUSED) {
   setContractedBraille(setting);
@@ -619,43 +624,136 @@ makeMidiInstrumentMenuStrings (void) {
 #endif /* HAVE_MIDI_SUPPORT */
 
 static Menu *logMessagesMenu = NULL;
-static const LogEntry *newestLogMessage = NULL;
 
-static int
-addNewLogMessages (const LogEntry *message) {
-  if (message == newestLogMessage) return 1;
-  if (!addNewLogMessages(getPreviousLogEntry(message))) return 0;
+/* The submenu mirrors the (bounded) log message history: its items are
+ * reused from one update to the next, those left over once the history has
+ * shrunk are removed, and each one owns a single copy of the text of the
+ * history entry it currently presents.
+ */
+typedef struct {
+  char label[0X20];
+  char comment[0X10];
+  char *text;
+} LogMessageItem;
+
+static struct {
+  LogMessageItem **array;
+  unsigned int size;
+  unsigned int count;
+  unsigned int index;
+} logMessageItems = {
+  .array = NULL
+};
+
+static LogMessageItem *
+newLogMessageItem (void) {
+  if (logMessageItems.count == logMessageItems.size) {
+    unsigned int newSize = logMessageItems.size? (logMessageItems.size << 1): 0X10;
+    LogMessageItem **newArray = realloc(logMessageItems.array, ARRAY_SIZE(newArray, newSize));
+
+    if (!newArray) {
+      logMallocError();
+      return NULL;
+    }
+
+    logMessageItems.array = newArray;
+    logMessageItems.size = newSize;
+  }
 
-  MenuString name;
-  const TimeValue *time = getLogEntryTime(message);
-  unsigned int count = getLogEntryCount(message);
+  LogMessageItem *lmi = malloc(sizeof(*lmi));
+
+  if (lmi) {
+    memset(lmi, 0, sizeof(*lmi));
+
+    MenuString name = {
+      .label = lmi->label,
+      .comment = lmi->comment
+    };
+
+    if (newTextMenuItem(logMessagesMenu, &name, "")) {
+      logMessageItems.array[logMessageItems.count++] = lmi;
+      return lmi;
+    }
 
-  if (time) {
-    char buffer[0X20];
-    formatSeconds(buffer, sizeof(buffer), "%Y-%m-%d@%H:%M:%S", time->seconds);
-    name.label = strdup(buffer);
+    free(lmi);
   } else {
-    name.label = NULL;
+    logMallocError();
   }
 
-  if (count > 1) {
-    char buffer[0X10];
-    snprintf(buffer, sizeof(buffer), "(%u)", count);
-    name.comment = strdup(buffer);
-  } else {
-    name.comment = NULL;
+  return NULL;
+}
+
+static void
+setLogMessageItemText (unsigned int index, const char *text) {
+  LogMessageItem *lmi = logMessageItems.array[index];
+
+  if (lmi->text) {
+    if (text && (strcmp(lmi->text, text) == 0)) return;
+    free(lmi->text);
+    lmi->text = NULL;
   }
 
-  MenuItem *item = newTextMenuItem(logMessagesMenu, &name, getLogEntryText(message));
-  if (!item) return 0;
+  if (text) {
+    if (!(lmi->text = strdup(text))) logMallocError();
+  }
+
+  setMenuItemText(getMenuItem(logMessagesMenu, index), (lmi->text? lmi->text: ""));
+}
 
-  newestLogMessage = message;
+static int
+addLogMessage (const LogEntry *message, void *data) {
+  unsigned int index = logMessageItems.index;
+  LogMessageItem *lmi;
+
+  if (index < logMessageItems.count) {
+    lmi = logMessageItems.array[index];
+  } else if (!(lmi = newLogMessageItem())) {
+    return 0;
+  }
+
+  logMessageItems.index += 1;
+
+  {
+    const TimeValue *time = getLogEntryTime(message);
+
+    if (time) {
+      formatSeconds(lmi->label, sizeof(lmi->label), "%Y-%m-%d@%H:%M:%S", time->seconds);
+    } else {
+      lmi->label[0] = 0;
+    }
+  }
+
+  {
+    unsigned int count = getLogEntryCount(message);
+
+    if (count > 1) {
+      snprintf(lmi->comment, sizeof(lmi->comment), "(%u)", count);
+    } else {
+      lmi->comment[0] = 0;
+    }
+  }
+
+  setLogMessageItemText(index, getLogEntryText(message));
   return 1;
 }
 
 int
 updateLogMessagesSubmenu (void) {
-  return addNewLogMessages(getNewestLogMessage(1));
+  unsigned long sequence = 0;
+  logMessageItems.index = 0;
+  int ok = processNewLogMessages(&sequence, addLogMessage, NULL);
+
+  if (logMessageItems.index < logMessageItems.count) {
+    removeMenuItems(logMessagesMenu, logMessageItems.index);
+
+    do {
+      LogMessageItem *lmi = logMessageItems.array[--logMessageItems.count];
+      if (lmi->text) free(lmi->text);
+      free(lmi);
+    } while (logMessageItems.count > logMessageItems.index);
+  }
+
+  return ok;
 }
 
 static Menu *
@@ -727,6 +825,12 @@ makePreferencesMenu (void) {
       TEST(ContractedBraille);
     }
 
+    {
+      NAME(strtext("Wrap Contracted Line"));
+      ITEM(newBooleanMenuItem(presentationSubmenu, &prefs.wrapContractedLine, &itemName));
+      TEST(MultipleContractedRows);
+    }
+
     {
       static const MenuString strings[] = {
         {.label=strtext("8-dot")},
@@ -294,10 +294,13 @@ loadMessageCatalog (void) {
   return loaded;
 }
 
+static void clearTranslationCache (void);
+
 void
 releaseMessageCatalog (void) {
   if (messageCatalog.view.data) free(messageCatalog.view.data);
   memset(&messageCatalog, 0, sizeof(messageCatalog));
+  clearTranslationCache();
 }
 
 static inline const MessageCatalogHeader *
@@ -444,8 +447,8 @@ getMessagesAttribute (const char *property, const char *name) {
   return NULL;
 }
 
-int
-findSourceMessage (const char *text, size_t textLength, unsigned int *index) {
+static int
+searchSourceMessages (const char *text, size_t textLength, unsigned int *index) {
   const Message *messages = getSourceMessages();
   int from = 0;
   int to = getMessageCount();
@@ -476,6 +479,86 @@ findSourceMessage (const char *text, size_t textLength, unsigned int *index) {
   return 0;
 }
 
+static const uint32_t *
+getHashTable (uint32_t *size) {
+  const MessageCatalogHeader *header = getHeader();
+  uint32_t hashSize = messageCatalog.getInteger(header->hashSize);
+  if (hashSize <= 2) return NULL;
+
+  uint32_t hashOffset = messageCatalog.getInteger(header->hashOffset);
+  if (hashOffset % sizeof(uint32_t)) return NULL;
+  if (hashOffset > messageCatalog.dataSize) return NULL;
+  if (hashSize > ((messageCatalog.dataSize - hashOffset) / sizeof(uint32_t))) return NULL;
+
+  *size = hashSize;
+  return getItem(header->hashOffset);
+}
+
+static uint32_t
+hashSourceMessage (const char *text, size_t length) {
+  // this must be the same as hash_string() in GNU gettext
+  const char *end = text + length;
+  uint32_t hash = 0;
+
+  while ((text < end) && *text) {
+    hash <<= 4;
+    hash += (unsigned char)*text++;
+
+    uint32_t high = hash & (UINT32_C(0XF) << 28);
+    if (high) hash ^= (high >> 24) ^ high;
+  }
+
+  return hash;
+}
+
+static int
+hashSourceMessages (
+  const uint32_t *table, uint32_t size,
+  const char *text, size_t textLength, unsigned int *index
+) {
+  const Message *messages = getSourceMessages();
+  uint32_t count = getMessageCount();
+
+  uint32_t hash = hashSourceMessage(text, textLength);
+  uint32_t slot = hash % size;
+  uint32_t increment = 1 + (hash % (size - 2));
+  uint32_t probes = size;
+
+  while (probes--) {
+    uint32_t entry = messageCatalog.getInteger(table[slot]);
+    if (!entry) break;
+    entry -= 1;
+
+    if (entry < count) {
+      const Message *message = &messages[entry];
+
+      if (getMessageLength(message) == textLength) {
+        if (memcmp(text, getMessageText(message), textLength) == 0) {
+          *index = entry;
+          return 1;
+        }
+      }
+    }
+
+    if (slot >= (size - increment)) {
+      slot -= size - increment;
+    } else {
+      slot += increment;
+    }
+  }
+
+  return 0;
+}
+
+int
+findSourceMessage (const char *text, size_t textLength, unsigned int *index) {
+  uint32_t size;
+  const uint32_t *table = getHashTable(&size);
+
+  if (table) return hashSourceMessages(table, size, text, textLength, index);
+  return searchSourceMessages(text, textLength, index);
+}
+
 const Message *
 findSimpleTranslation (const char *text, size_t length) {
   if (!text) return NULL;
@@ -492,10 +575,63 @@ findSimpleTranslation (const char *text, size_t length) {
   return NULL;
 }
 
+/* Most translated strings are literals, so remember where the translation of
+ * a given source string pointer was found. A hit is still verified against
+ * the catalog since the same pointer may later refer to different text.
+ */
+
+#define TRANSLATION_CACHE_SIZE 0X100
+
+typedef struct {
+  const char *source;
+  unsigned int index;
+} TranslationCacheEntry;
+
+static TranslationCacheEntry translationCache[TRANSLATION_CACHE_SIZE];
+
+static void
+clearTranslationCache (void) {
+  memset(translationCache, 0, sizeof(translationCache));
+}
+
+static inline TranslationCacheEntry *
+getTranslationCacheEntry (const char *text) {
+  uintptr_t key = (uintptr_t)text;
+  key ^= key >> 12;
+  return &translationCache[(key >> 3) % TRANSLATION_CACHE_SIZE];
+}
+
 const char *
 getSimpleTranslation (const char *text) {
-  const Message *translation = findSimpleTranslation(text, strlen(text));
-  if (translation) return getMessageText(translation);
+  if (!text) return text;
+  if (!*text) return text;
+
+  if (loadMessageCatalog()) {
+    TranslationCacheEntry *entry = getTranslationCacheEntry(text);
+    TranslationCacheEntry cached = *entry;
+
+    if (cached.source == text) {
+      if (cached.index < getMessageCount()) {
+        const Message *message = getSourceMessage(cached.index);
+        size_t length = strlen(text);
+
+        if (getMessageLength(message) == length) {
+          if (memcmp(text, getMessageText(message), length) == 0) {
+            return getMessageText(getTranslatedMessage(cached.index));
+          }
+        }
+      }
+    }
+
+    unsigned int index;
+
+    if (findSourceMessage(text, strlen(text), &index)) {
+      entry->source = text;
+      entry->index = index;
+      return getMessageText(getTranslatedMessage(index));
+    }
+  }
+
   return text;
 }
 
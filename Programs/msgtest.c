@@ -28,6 +28,7 @@
 #include "messages.h"
 #include "parse.h"
 #include "file.h"
+#include "timing.h"
 
 static char *opt_localeDirectory;
 static char *opt_localeSpecifier;
@@ -186,6 +187,51 @@ showProperty (const char *propertyName, const char *attributeName) {
   return ok;
 }
 
+typedef int TranslationLookupFunction (const Message *source);
+
+static int
+lookupSourceMessage (const Message *source) {
+  unsigned int index;
+  return findSourceMessage(getMessageText(source), getMessageLength(source), &index);
+}
+
+static int
+lookupSimpleTranslation (const Message *source) {
+  const char *text = getMessageText(source);
+  if (strlen(text) != getMessageLength(source)) return 0;
+  return getSimpleTranslation(text) != text;
+}
+
+static int
+benchmarkLookups (const char *label, TranslationLookupFunction *lookup, int iterations) {
+  uint32_t count = getMessageCount();
+  unsigned long int lookups = 0;
+  unsigned long int found = 0;
+
+  TimeValue start;
+  getMonotonicTime(&start);
+
+  for (int iteration=0; iteration<iterations; iteration+=1) {
+    for (unsigned int index=0; index<count; index+=1) {
+      const Message *source = getSourceMessage(index);
+      if (getMessageLength(source) == 0) continue;
+
+      if (lookup(source)) found += 1;
+      lookups += 1;
+    }
+  }
+
+  long int elapsed = getMonotonicElapsed(&start);
+  unsigned long int rate = elapsed? ((lookups * MSECS_PER_SEC) / elapsed): 0;
+
+  fprintf(outputStream,
+    "%s: %lu lookups (%lu found) in %ldms: %lu/s\n",
+    label, lookups, found, elapsed, rate
+  );
+
+  return noOutputErrorYet();
+}
+
 static int
 parseQuantity (int *count, const char *quantity) {
   static const int minimum = 0;
@@ -288,6 +334,14 @@ main (int argc, char *argv[]) {
     beginAction(&argv, &argc);
     fprintf(outputStream, "%s\n", getMessagesMetadata());
     ok = noOutputErrorYet();
+  } else if (isAbbreviation("benchmark", action)) {
+    const char *quantity = nextParameter(&argv, &argc, NULL);
+    int iterations = 1000;
+    if (quantity && !parseQuantity(&iterations, quantity)) return PROG_EXIT_SYNTAX;
+
+    beginAction(&argv, &argc);
+    ok = benchmarkLookups("catalog", lookupSourceMessage, iterations)
+      && benchmarkLookups("gettext", lookupSimpleTranslation, iterations);
   } else if (isAbbreviation("property", action)) {
     const char *property = nextParameter(&argv, &argc, "property name");
     const char *attribute = nextParameter(&argv, &argc, NULL);
@@ -32,6 +32,7 @@
 #include "datafile.h"
 #include "utf8.h"
 #include "parse.h"
+#include "startup.h"
 
 #undef ALLOW_DOS_OPTION_SYNTAX
 #if defined(__MINGW32__) || defined(__MSDOS__)
@@ -1069,7 +1070,9 @@ processOptions (const OptionsDescriptor *descriptor, int *argumentCount, char **
     int configurationFileSpecified = descriptor->configurationFile && *descriptor->configurationFile;
 
     if (configurationFileSpecified) {
+      beginStartupPhase("configuration file");
       processConfigurationFile(&info, *descriptor->configurationFile, !configurationFileSpecified);
+      endStartupPhase();
     }
   }
   processInternalSettings(&info, 1);
@@ -48,6 +48,14 @@ extern "C" {
 #define SCREEN_UPDATE_POLL_INTERVAL 40
 #define SCREEN_UPDATE_SCHEDULE_DELAY 5
 
+#define SCROLLBACK_MAXIMUM_ROWS 0X1000
+#define SCROLLBACK_MAXIMUM_SIZE 0X200000
+#define SCROLLBACK_SCREEN_LIMIT 8
+#define SCROLLBACK_MINIMUM_OVERLAP 2
+
+#define CLIPBOARD_HISTORY_MAXIMUM_ENTRIES 0X100
+#define CLIPBOARD_HISTORY_MAXIMUM_SIZE 0X40000
+
 #define KEYBOARD_MONITOR_START_RETRY_INTERVAL 5000
 
 #define PID_FILE_CREATE_RETRY_INTERVAL 5000
@@ -56,7 +64,10 @@ extern "C" {
 
 #define ROUTING_PROCESS_NICENESS 10
 #define ROUTING_POLL_INTERVAL 1
+#define ROUTING_UPDATE_CHECK_INTERVAL 50
 #define ROUTING_MAXIMUM_TIMEOUT 2000
+#define ROUTING_MAXIMUM_BURST 8
+#define ROUTING_PROFILE_LIMIT 0X10
 
 #define TUNE_DEVICE_CLOSE_DELAY 2000
 #define TUNE_TOGGLE_REPEAT_DELAY 100
@@ -254,6 +254,12 @@ const PreferenceDefinition preferenceDefinitionTable[] = {
     .setting = &prefs.capitalizationMode
   },
 
+  { .name = "wrap-contracted-line",
+    .defaultValue = DEFAULT_WRAP_CONTRACTED_LINE,
+    .settingNames = &preferenceStringTable_boolean,
+    .setting = &prefs.wrapContractedLine
+  },
+
   { .name = "braille-firmness",
     .defaultValue = DEFAULT_BRAILLE_FIRMNESS,
     .settingNames = &preferenceStringTable_brailleFirmness,
@@ -35,6 +35,7 @@
 #include "file.h"
 #include "parse.h"
 #include "system.h"
+#include "thread.h"
 
 const char standardStreamArgument[] = "-";
 const char standardInputName[] = "<standard-input>";
@@ -341,6 +342,7 @@ cancelProgram (const char *pidFile) {
 
 typedef struct ProgramExitEntryStruct ProgramExitEntry;
 static ProgramExitEntry *programExitEntries = NULL;
+static CriticalSectionLock programExitLock = CRITICAL_SECTION_LOCK_INITIALIZER;
 
 struct ProgramExitEntryStruct {
   ProgramExitEntry *next;
@@ -358,8 +360,11 @@ onProgramExit (const char *name, ProgramExitHandler *handler, void *data) {
     pxe->handler = handler;
     pxe->data = data;
 
-    pxe->next = programExitEntries;
-    programExitEntries = pxe;
+    enterCriticalSection(&programExitLock);
+      pxe->next = programExitEntries;
+      programExitEntries = pxe;
+    leaveCriticalSection(&programExitLock);
+
     logMessage(LOG_DEBUG, "program exit event added: %s", name);
   } else {
     logMallocError();
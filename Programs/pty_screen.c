@@ -18,11 +18,17 @@
 
 #include "prologue.h"
 
+#include <string.h>
+#include <wchar.h>
+
 #include "log.h"
 #include "pty_screen.h"
 #include "scr_emulator.h"
 #include "msg_queue.h"
 #include "utf8.h"
+#include "timing.h"
+#include "async_handle.h"
+#include "async_alarm.h"
 
 static unsigned char screenLogLevel = LOG_DEBUG;
 
@@ -38,6 +44,67 @@ static unsigned char defaultForegroundColor;
 static unsigned char defaultBackgroundColor;
 static unsigned char colorPairMap[0100];
 
+/* The screen segment is maintained directly from what's written rather than
+ * by reading each cell back from curses, which only mirrors it onto the real
+ * terminal. These are the cells which text and erasures currently produce.
+ */
+static attr_t currentAttributes;
+static ScreenSegmentCharacter currentCharacter;
+static ScreenSegmentCharacter blankCharacter;
+static mbstate_t outputState;
+
+static void
+setColor (ScreenSegmentColor *ssc, unsigned char color, unsigned char level) {
+  if (color & COLOR_RED) ssc->red = level;
+  if (color & COLOR_GREEN) ssc->green = level;
+  if (color & COLOR_BLUE) ssc->blue = level;
+}
+
+static void
+makeCharacter (
+  ScreenSegmentCharacter *character, attr_t attributes,
+  unsigned char fgColor, unsigned char bgColor
+) {
+  *character = (ScreenSegmentCharacter){
+    .text = ' ',
+    .alpha = UINT8_MAX,
+  };
+
+  {
+    unsigned char bgLevel = SCREEN_SEGMENT_COLOR_LEVEL;
+    unsigned char fgLevel = bgLevel;
+
+    if (attributes & (A_BOLD | A_STANDOUT)) fgLevel = UINT8_MAX;
+    if (attributes & A_DIM) fgLevel >>= 1, bgLevel >>= 1;
+
+    {
+      ScreenSegmentColor *cfg, *cbg;
+
+      if (attributes & A_REVERSE) {
+        cfg = &character->background;
+        cbg = &character->foreground;
+      } else {
+        cfg = &character->foreground;
+        cbg = &character->background;
+      }
+
+      setColor(cfg, fgColor, fgLevel);
+      setColor(cbg, bgColor, bgLevel);
+    }
+  }
+
+  if (attributes & A_BLINK) character->blink = 1;
+  if (attributes & A_UNDERLINE) character->underline = 1;
+}
+
+static void
+updateCurrentCharacter (void) {
+  makeCharacter(
+    &currentCharacter, currentAttributes,
+    currentForegroundColor, currentBackgroundColor
+  );
+}
+
 static unsigned char
 toColorPair (unsigned char foreground, unsigned char background) {
   return colorPairMap[(background << 3) | foreground];
@@ -47,6 +114,9 @@ static void
 initializeColors (unsigned char foreground, unsigned char background) {
   currentForegroundColor = defaultForegroundColor = foreground;
   currentBackgroundColor = defaultBackgroundColor = background;
+
+  makeCharacter(&blankCharacter, A_NORMAL, foreground, background);
+  updateCurrentCharacter();
 }
 
 static void
@@ -108,6 +178,60 @@ enableMessages (key_t key) {
   haveTerminalMessageQueue = createMessageQueue(&terminalMessageQueue, key);
 }
 
+/* Only the first of a burst of updates is notified (see
+ * SCREEN_SEGMENT_FLAG_UPDATED), and, if an interval has been set,
+ * notifications are no closer together than that.
+ */
+static int updateNotificationInterval = 0;
+static TimeValue updateNotificationTime;
+static AsyncHandle updateNotificationAlarm = NULL;
+
+void
+ptySetScreenUpdateInterval (int milliseconds) {
+  updateNotificationInterval = milliseconds;
+}
+
+static void
+sendUpdateNotification (void) {
+  getMonotonicTime(&updateNotificationTime);
+  sendTerminalMessage(TERM_MSG_SEGMENT_UPDATED, NULL, 0);
+}
+
+ASYNC_ALARM_CALLBACK(handleUpdateNotificationAlarm) {
+  asyncDiscardHandle(updateNotificationAlarm);
+  updateNotificationAlarm = NULL;
+  sendUpdateNotification();
+}
+
+static void
+notifySegmentUpdated (void) {
+  if (updateNotificationAlarm) return;
+
+  if (updateNotificationInterval > 0) {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    long int elapsed = millisecondsBetween(&updateNotificationTime, &now);
+    long int delay = updateNotificationInterval - elapsed;
+
+    if ((delay > 0) && (elapsed >= 0)) {
+      if (asyncNewRelativeAlarm(&updateNotificationAlarm, delay, handleUpdateNotificationAlarm, NULL)) {
+        return;
+      }
+    }
+  }
+
+  sendUpdateNotification();
+}
+
+static void
+cancelUpdateNotification (void) {
+  if (updateNotificationAlarm) {
+    asyncCancelRequest(updateNotificationAlarm);
+    updateNotificationAlarm = NULL;
+  }
+}
+
 static int segmentIdentifier = 0;
 static ScreenSegmentHeader *segmentHeader = NULL;
 
@@ -144,87 +268,10 @@ storeCursorPosition (void) {
 }
 
 static void
-setColor (ScreenSegmentColor *ssc, unsigned char color, unsigned char level) {
-  if (color & COLOR_RED) ssc->red = level;
-  if (color & COLOR_GREEN) ssc->green = level;
-  if (color & COLOR_BLUE) ssc->blue = level;
-}
-
-static ScreenSegmentCharacter *
-setCharacter (unsigned int row, unsigned int column, ScreenSegmentCharacter **end) {
-  wchar_t text;
-  attr_t attributes;
-  int colorPair;
-
-  {
-    unsigned int oldRow = segmentHeader->cursorRow;
-    unsigned int oldColumn = segmentHeader->cursorColumn;
-    int move = (row != oldRow) || (column != oldColumn);
-    if (move) ptySetCursorPosition(row, column);
-
-    {
-    #ifdef GOT_CURSES_WCH
-      cchar_t character;
-      in_wch(&character);
-
-      text = character.chars[0];
-      attributes = character.attr;
-      colorPair = character.ext_color;
-    #else /* GOT_CURSES_WCH */
-      chtype character = inch();
-      text = character & A_CHARTEXT;
-      attributes = character & A_ATTRIBUTES;
-      colorPair = PAIR_NUMBER(character);
-    #endif /* GOT_CURSES_WCH */
-    }
-
-    if (move) ptySetCursorPosition(oldRow, oldColumn);
-  }
-
-  ScreenSegmentCharacter character = {
-    .text = text,
-    .alpha = UINT8_MAX,
-  };
-
-  {
-    short fgColor, bgColor;
-    pair_content(colorPair, &fgColor, &bgColor);
-
-    unsigned char bgLevel = SCREEN_SEGMENT_COLOR_LEVEL;
-    unsigned char fgLevel = bgLevel;
-
-    if (attributes & (A_BOLD | A_STANDOUT)) fgLevel = UINT8_MAX;
-    if (attributes & A_DIM) fgLevel >>= 1, bgLevel >>= 1;
-
-    {
-      ScreenSegmentColor *cfg, *cbg;
-
-      if (attributes & A_REVERSE) {
-        cfg = &character.background;
-        cbg = &character.foreground;
-      } else {
-        cfg = &character.foreground;
-        cbg = &character.background;
-      }
-
-      setColor(cfg, fgColor, fgLevel);
-      setColor(cbg, bgColor, bgLevel);
-    }
-  }
-
-  if (attributes & A_BLINK) character.blink = 1;
-  if (attributes & A_UNDERLINE) character.underline = 1;
-
-  {
-    ScreenSegmentCharacter *location = getScreenCharacter(segmentHeader, row, column, end);
-    *location = character;
-    return location;
-  }
-}
-
-static ScreenSegmentCharacter *
-setCurrentCharacter (ScreenSegmentCharacter **end) {
-  return setCharacter(segmentHeader->cursorRow, segmentHeader->cursorColumn, end);
+setCharacter (unsigned int row, unsigned int column, wchar_t text) {
+  ScreenSegmentCharacter *location = getScreenCharacter(segmentHeader, row, column, NULL);
+  *location = currentCharacter;
+  location->text = text;
 }
 
 static ScreenSegmentCharacter *
@@ -234,8 +281,8 @@ getCurrentCharacter (ScreenSegmentCharacter **end) {
 
 static void
 fillCharacters (unsigned int row, unsigned int column, unsigned int count) {
-  ScreenSegmentCharacter *from = setCharacter(row, column, NULL);
-  propagateScreenCharacter(from, (from + count));
+  ScreenSegmentCharacter *from = getScreenCharacter(segmentHeader, row, column, NULL);
+  setScreenCharacters(from, (from + count), &blankCharacter);
 }
 
 static void
@@ -282,6 +329,12 @@ ptyBeginScreen (PtyObject *pty) {
     savedCursorRow = 0;
     savedCursorColumn = 0;
 
+    currentAttributes = A_NORMAL;
+    memset(&outputState, 0, sizeof(outputState));
+
+    updateNotificationAlarm = NULL;
+    memset(&updateNotificationTime, 0, sizeof(updateNotificationTime));
+
     hasColors = has_colors();
     initializeColors(COLOR_WHITE, COLOR_BLACK);
 
@@ -310,6 +363,7 @@ ptyBeginScreen (PtyObject *pty) {
 
 void
 ptyEndScreen (void) {
+  cancelUpdateNotification();
   endwin();
   sendTerminalMessage(TERM_MSG_EMULATOR_EXITING, NULL, 0);
   detachScreenSegment(segmentHeader);
@@ -318,7 +372,13 @@ ptyEndScreen (void) {
 
 void
 ptyRefreshScreen (void) {
-  sendTerminalMessage(TERM_MSG_SEGMENT_UPDATED, NULL, 0);
+  segmentHeader->updateNumber += 1;
+
+  {
+    uint32_t oldFlags = setScreenSegmentFlags(segmentHeader, SCREEN_SEGMENT_FLAG_UPDATED);
+    if (!(oldFlags & SCREEN_SEGMENT_FLAG_UPDATED)) notifySegmentUpdated();
+  }
+
   refresh();
 }
 
@@ -368,6 +428,17 @@ ptyAmWithinScrollRegion (void) {
   return isWithinScrollRegion(segmentHeader->cursorRow);
 }
 
+static void
+scrollRowsForward (unsigned int count) {
+  unsigned int row = scrollRegionTop;
+  unsigned int end = scrollRegionBottom + 1;
+  unsigned int size = end - row;
+
+  if (count > size) count = size;
+  moveRows((row + count), row, (size - count));
+  fillRows((end - count), count);
+}
+
 void
 ptyScrollBackward (unsigned int count) {
   unsigned int row = scrollRegionTop;
@@ -383,15 +454,12 @@ ptyScrollBackward (unsigned int count) {
 
 void
 ptyScrollForward (unsigned int count) {
-  unsigned int row = scrollRegionTop;
-  unsigned int end = scrollRegionBottom + 1;
-  unsigned int size = end - row;
+  unsigned int size = scrollRegionBottom + 1 - scrollRegionTop;
 
   if (count > size) count = size;
   scrl(count);
 
-  moveRows((row + count), row, (size - count));
-  fillRows((end - count), count);
+  scrollRowsForward(count);
 }
 
 void
@@ -510,6 +578,26 @@ ptyDeleteCharacters (unsigned int count) {
   fillCharacters(segmentHeader->cursorRow, (COLS - count), count);
 }
 
+static int
+getCharacterText (unsigned char byte, wchar_t *text) {
+#ifdef GOT_CURSES_WCH
+  // curses decodes multibyte characters the same way
+  char character = byte;
+  size_t result = mbrtowc(text, &character, 1, &outputState);
+
+  if (result == (size_t)-2) return 0;
+
+  if (result == (size_t)-1) {
+    memset(&outputState, 0, sizeof(outputState));
+    *text = byte;
+  }
+#else /* GOT_CURSES_WCH */
+  *text = byte;
+#endif /* GOT_CURSES_WCH */
+
+  return 1;
+}
+
 void
 ptyAddCharacter (unsigned char character) {
   unsigned int row = segmentHeader->cursorRow;
@@ -518,7 +606,47 @@ ptyAddCharacter (unsigned char character) {
   addch(character);
   storeCursorPosition();
 
-  setCharacter(row, column, NULL);
+  wchar_t text;
+  if (!getCharacterText(character, &text)) return;
+  setCharacter(row, column, text);
+
+  if ((row == scrollRegionBottom) &&
+      (segmentHeader->cursorRow == row) &&
+      (segmentHeader->cursorColumn < column)) {
+    // curses wrapped onto a new line at the bottom of the scroll region
+    scrollRowsForward(1);
+  }
+}
+
+size_t
+ptyAddText (const unsigned char *text, size_t count) {
+#ifdef GOT_CURSES_WCH
+  // a multibyte character is still incomplete
+  if (!mbsinit(&outputState)) return 0;
+#endif /* GOT_CURSES_WCH */
+
+  unsigned int row = segmentHeader->cursorRow;
+  unsigned int column = segmentHeader->cursorColumn;
+
+  // stop short of the last column so that curses doesn't wrap
+  if ((column + 1) >= COLS) return 0;
+  size_t room = COLS - 1 - column;
+  if (count > room) count = room;
+  if (!count) return 0;
+
+  addnstr((const char *)text, count);
+  storeCursorPosition();
+
+  ScreenSegmentCharacter *cell = getScreenCharacter(segmentHeader, row, column, NULL);
+  const unsigned char *end = text + count;
+
+  while (text < end) {
+    *cell = currentCharacter;
+    cell->text = *text++;
+    cell += 1;
+  }
+
+  return count;
 }
 
 void
@@ -529,22 +657,34 @@ ptySetCursorVisibility (unsigned int visibility) {
 void
 ptySetAttributes (attr_t attributes) {
   attrset(attributes);
+  currentAttributes = attributes & ~A_COLOR;
+
+  // the color pair has been reset as well
+  currentForegroundColor = defaultForegroundColor;
+  currentBackgroundColor = defaultBackgroundColor;
+
+  updateCurrentCharacter();
 }
 
 void
 ptyAddAttributes (attr_t attributes) {
   attron(attributes);
+  currentAttributes |= attributes & ~A_COLOR;
+  updateCurrentCharacter();
 }
 
 void
 ptyRemoveAttributes (attr_t attributes) {
   attroff(attributes);
+  currentAttributes &= ~attributes;
+  updateCurrentCharacter();
 }
 
 static void
 setCharacterColors (void) {
   attroff(A_COLOR);
   attron(COLOR_PAIR(toColorPair(currentForegroundColor, currentBackgroundColor)));
+  updateCurrentCharacter();
 }
 
 void
@@ -565,9 +705,9 @@ void
 ptyClearToEndOfDisplay (void) {
   clrtobot();
 
-  ScreenSegmentCharacter *from = setCurrentCharacter(NULL);
+  ScreenSegmentCharacter *from = getCurrentCharacter(NULL);
   const ScreenSegmentCharacter *to = getScreenEnd(segmentHeader);
-  propagateScreenCharacter(from, to);
+  setScreenCharacters(from, to, &blankCharacter);
 }
 
 void
@@ -575,8 +715,8 @@ ptyClearToEndOfLine (void) {
   clrtoeol();
 
   ScreenSegmentCharacter *to;
-  ScreenSegmentCharacter *from = setCurrentCharacter(&to);
-  propagateScreenCharacter(from, to);
+  ScreenSegmentCharacter *from = getCurrentCharacter(&to);
+  setScreenCharacters(from, to, &blankCharacter);
 }
 
 void
@@ -50,6 +50,11 @@ ptySetTerminalLogLevel (unsigned char level) {
   ptySetScreenLogLevel(level);
 }
 
+void
+ptySetTerminalUpdateInterval (int milliseconds) {
+  ptySetScreenUpdateInterval(milliseconds);
+}
+
 void
 ptySetLogTerminalInput (int yes) {
   logInput = yes;
@@ -822,6 +827,57 @@ parseOutputByte (unsigned char byte) {
   }
 }
 
+/* Most output is plain text so runs of printable ASCII characters are found
+ * a word at a time and given to the screen together rather than each being
+ * dispatched through the sequence parser.
+ */
+#define TEXT_WORD_ONES (UINT64_MAX / UINT8_MAX)
+#define TEXT_WORD_HIGHS (TEXT_WORD_ONES * 0X80)
+
+static inline int
+isTextWord (uint64_t word) {
+  uint64_t controls = (word - (TEXT_WORD_ONES * 0X20)) & ~word;
+  uint64_t deletes = word ^ (TEXT_WORD_ONES * ASCII_DEL);
+  deletes = (deletes - TEXT_WORD_ONES) & ~deletes;
+  return !((word | controls | deletes) & TEXT_WORD_HIGHS);
+}
+
+static inline int
+isTextByte (unsigned char byte) {
+  return (byte >= 0X20) && (byte < ASCII_DEL);
+}
+
+static size_t
+getTextLength (const unsigned char *bytes, size_t count) {
+  const unsigned char *byte = bytes;
+  const unsigned char *end = byte + count;
+  uint64_t word;
+
+  while ((end - byte) >= sizeof(word)) {
+    memcpy(&word, byte, sizeof(word));
+    if (!isTextWord(word)) break;
+    byte += sizeof(word);
+  }
+
+  while ((byte < end) && isTextByte(*byte)) byte += 1;
+  return byte - bytes;
+}
+
+static size_t
+processOutputText (const unsigned char *bytes, size_t count) {
+  if (outputParserState != OPS_BASIC) return 0;
+  if (insertMode) return 0;
+
+  // a line's worth at most since that's as much as can be added at once
+  if (count > COLS) count = COLS;
+  count = getTextLength(bytes, count);
+  if (!count) return 0;
+
+  count = ptyAddText(bytes, count);
+  if (count && logOutput) logBytes(terminalLogLevel, "output", bytes, count);
+  return count;
+}
+
 int
 ptyProcessTerminalOutput (const unsigned char *bytes, size_t count) {
   int wantRefresh = 0;
@@ -830,7 +886,17 @@ ptyProcessTerminalOutput (const unsigned char *bytes, size_t count) {
   const unsigned char *end = byte + count;
 
   while (byte < end) {
-    wantRefresh = parseOutputByte(*byte++);
+    {
+      size_t length = processOutputText(byte, (end - byte));
+
+      if (length) {
+        byte += length;
+        wantRefresh = 1;
+        continue;
+      }
+    }
+
+    if (parseOutputByte(*byte++)) wantRefresh = 1;
   }
 
   if (wantRefresh) {
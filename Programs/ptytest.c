@@ -0,0 +1,212 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "file.h"
+#include "timing.h"
+#include "pty_object.h"
+#include "pty_terminal.h"
+
+static char *opt_iterations;
+static char *opt_chunkSize;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "iterations",
+    .letter = 'i',
+    .argument = "count",
+    .setting.string = &opt_iterations,
+    .internal.setting = "100",
+    .description = "the number of times to process the output"
+  },
+
+  { .word = "chunk-size",
+    .letter = 'c',
+    .argument = "bytes",
+    .setting.string = &opt_chunkSize,
+    .internal.setting = "4096",
+    .description = "the number of bytes to process at a time (brltty-pty reads 4096)"
+  },
+END_OPTION_TABLE
+
+/* a screenful of typical (coloured) terminal output */
+static const char defaultOutput[] =
+  "\033[01;32muser@host\033[00m:\033[01;34m~/src/brltty\033[00m$ ls -l --color\r\n"
+  "total 1024\r\n"
+  "-rw-r--r-- 1 user user  4096 Jan  1 12:00 \033[0mMakefile\033[0m\r\n"
+  "drwxr-xr-x 2 user user  4096 Jan  1 12:00 \033[01;34mPrograms\033[0m\r\n"
+  "-rwxr-xr-x 1 user user 81920 Jan  1 12:00 \033[01;32mconfigure\033[0m\r\n"
+  "\033[01;32muser@host\033[00m:\033[01;34m~/src/brltty\033[00m$ make -j4\r\n"
+  "gcc -c -O2 -Wall -o core.o core.c\r\n"
+  "gcc -c -O2 -Wall -o config.o config.c\r\n"
+  "core.c: In function '\033[01m\033[Kmain\033[m\033[K':\r\n"
+  "core.c:42:7: \033[01;35m\033[Kwarning: \033[m\033[Kunused variable '\033[01m\033[Kx\033[m\033[K'\r\n"
+  "make[1]: Leaving directory '/home/user/src/brltty/Programs'\r\n"
+  "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the\r\n"
+  "lazy dog. The quick brown fox jumps over the lazy dog.\r\n"
+  "\tindented\ttext\twith\ttabs\r\n"
+  "\033[7m--More--(42%)\033[27m\r\033[K"
+  "Press RETURN to continue, or q to quit\r\n"
+  ;
+
+static int
+loadOutput (const char *path, unsigned char **buffer, size_t *size) {
+  FILE *stream = openFile(path, "r", 0);
+  if (!stream) return 0;
+  int ok = 1;
+
+  while (1) {
+    unsigned char bytes[0X1000];
+    size_t count = fread(bytes, 1, sizeof(bytes), stream);
+
+    if (count) {
+      unsigned char *newBuffer = realloc(*buffer, (*size + count));
+
+      if (!newBuffer) {
+        logMallocError();
+        ok = 0;
+        break;
+      }
+
+      memcpy(&newBuffer[*size], bytes, count);
+      *buffer = newBuffer;
+      *size += count;
+    }
+
+    if (count < sizeof(bytes)) {
+      if (ferror(stream)) {
+        logMessage(LOG_ERR, "input error: %s: %s", path, strerror(errno));
+        ok = 0;
+      }
+
+      break;
+    }
+  }
+
+  fclose(stream);
+  return ok;
+}
+
+static int
+processOutput (const unsigned char *bytes, size_t size, size_t chunkSize) {
+  const unsigned char *end = bytes + size;
+
+  while (bytes < end) {
+    size_t count = end - bytes;
+    if (count > chunkSize) count = chunkSize;
+
+    if (!ptyProcessTerminalOutput(bytes, count)) return 0;
+    bytes += count;
+  }
+
+  return 1;
+}
+
+int
+main (int argc, char *argv[]) {
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "ptytest",
+      .argumentsSummary = "[file ...]"
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  int iterations;
+  int chunkSize;
+
+  {
+    static const int minimum = 1;
+
+    if (!validateInteger(&iterations, opt_iterations, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid iteration count: %s", opt_iterations);
+      return PROG_EXIT_SYNTAX;
+    }
+
+    if (!validateInteger(&chunkSize, opt_chunkSize, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid chunk size: %s", opt_chunkSize);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
+  ProgramExitStatus exitStatus = PROG_EXIT_FATAL;
+  unsigned char *output = NULL;
+  size_t size = 0;
+  int loaded = 1;
+
+  if (argc) {
+    while (argc) {
+      if (!(loaded = loadOutput(*argv, &output, &size))) break;
+      argv += 1, argc -= 1;
+    }
+  } else if ((output = malloc(size = sizeof(defaultOutput) - 1))) {
+    memcpy(output, defaultOutput, size);
+  } else {
+    logMallocError();
+    loaded = 0;
+  }
+
+  if (loaded) {
+    PtyObject *pty = ptyNewObject();
+
+    if (pty) {
+      if (ptyBeginTerminal(pty)) {
+        unsigned long int bytes = 0;
+        int ok = 1;
+
+        TimeValue start;
+        getMonotonicTime(&start);
+
+        for (int iteration=0; iteration<iterations; iteration+=1) {
+          if (!(ok = processOutput(output, size, chunkSize))) break;
+          bytes += size;
+        }
+
+        long int elapsed = getMonotonicElapsed(&start);
+        ptyEndTerminal();
+
+        if (ok) {
+          unsigned long int rate = elapsed? ((bytes * MSECS_PER_SEC) / elapsed): 0;
+
+          /* curses owns standard output */
+          fprintf(stderr,
+            "output: %lu bytes in %ldms: %lu/s\n",
+            bytes, elapsed, rate
+          );
+
+          exitStatus = PROG_EXIT_SUCCESS;
+        }
+      }
+
+      ptyDestroyObject(pty);
+    }
+  }
+
+  if (output) free(output);
+  return exitStatus;
+}
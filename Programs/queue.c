@@ -22,6 +22,15 @@
 #include "queue.h"
 #include "lock.h"
 #include "program.h"
+#include "memusage.h"
+
+/* Discarded elements are kept for reuse. Each queue has its own small pool,
+ * which is only ever touched while the queue itself is being changed (so it
+ * needs no lock of its own), and the overflow goes to a shared pool (which
+ * does need a lock). Most enqueues, therefore, neither lock nor allocate.
+ */
+
+#define QUEUE_ELEMENT_POOL_LIMIT 0X20
 
 static Element *discardedElements = NULL;
 
@@ -42,12 +51,38 @@ unlockDiscardedElements (void) {
   releaseLock(getDiscardedElementsLock());
 }
 
+typedef struct {
+  unsigned long queueHits;
+  unsigned long sharedHits;
+  unsigned long allocations;
+} ElementPoolStatistics;
+
+static ElementPoolStatistics elementPoolStatistics = {
+  .queueHits = 0,
+  .sharedHits = 0,
+  .allocations = 0
+};
+
+static inline void
+countElementPoolEvent (unsigned long *counter) {
+#ifdef HAVE_SYNC_ADD_AND_FETCH
+  __sync_add_and_fetch(counter, 1);
+#else /* HAVE_SYNC_ADD_AND_FETCH */
+  *counter += 1;
+#endif /* HAVE_SYNC_ADD_AND_FETCH */
+}
+
 struct QueueStruct {
   Element *head;
   unsigned int size;
   void *data;
   ItemDeallocator *deallocateItem;
   ItemComparator *compareItems;
+
+  struct {
+    Element *elements;
+    unsigned int count;
+  } pool;
 };
 
 struct ElementStruct {
@@ -87,28 +122,50 @@ removeItem (Element *element) {
   }
 }
 
+static void
+shareElements (Element *first, Element *last) {
+  lockDiscardedElements();
+    last->next = discardedElements;
+    discardedElements = first;
+  unlockDiscardedElements();
+}
+
 static void
 discardElement (Element *element) {
+  Queue *queue = element->queue;
+
   removeItem(element);
   removeElement(element);
 
-  lockDiscardedElements();
-    element->next = discardedElements;
-    discardedElements = element;
-  unlockDiscardedElements();
+  if (queue->pool.count < QUEUE_ELEMENT_POOL_LIMIT) {
+    element->next = queue->pool.elements;
+    queue->pool.elements = element;
+    queue->pool.count += 1;
+  } else {
+    shareElements(element, element);
+  }
 }
 
 static Element *
-retrieveElement (void) {
+retrieveElement (Queue *queue) {
   Element *element;
 
-  lockDiscardedElements();
-    if ((element = discardedElements)) {
-      discardedElements = element->next;
-      element->next = NULL;
-    }
-  unlockDiscardedElements();
+  if ((element = queue->pool.elements)) {
+    queue->pool.elements = element->next;
+    queue->pool.count -= 1;
+    countElementPoolEvent(&elementPoolStatistics.queueHits);
+  } else {
+    lockDiscardedElements();
+      if ((element = discardedElements)) {
+        discardedElements = element->next;
+      }
+    unlockDiscardedElements();
 
+    if (!element) return NULL;
+    countElementPoolEvent(&elementPoolStatistics.sharedHits);
+  }
+
+  element->next = NULL;
   return element;
 }
 
@@ -116,12 +173,15 @@ static Element *
 newElement (Queue *queue, void *item) {
   Element *element;
 
-  if (!(element = retrieveElement())) {
+  if (!(element = retrieveElement(queue))) {
     if (!(element = malloc(sizeof(*element)))) {
       logMallocError();
       return NULL;
     }
 
+    addMemoryUsage(MEMORY_QUEUES, sizeof(*element));
+    countElementPoolEvent(&elementPoolStatistics.allocations);
+
     element->previous = element->next = NULL;
   }
 
@@ -258,10 +318,20 @@ static int queueInitialized = 0;
 
 static void
 exitQueue (void *data) {
+  {
+    const ElementPoolStatistics *eps = &elementPoolStatistics;
+
+    logMessage(LOG_CATEGORY(MEMORY_USAGE),
+      "queue element pools: queue hits=%lu shared hits=%lu allocations=%lu",
+      eps->queueHits, eps->sharedHits, eps->allocations
+    );
+  }
+
   lockDiscardedElements();
     while (discardedElements) {
       Element *element = discardedElements;
       discardedElements = element->next;
+      subtractMemoryUsage(MEMORY_QUEUES, sizeof(*element));
       free(element);
     }
   unlockDiscardedElements();
@@ -279,11 +349,16 @@ newQueue (ItemDeallocator *deallocateItem, ItemComparator *compareItems) {
   }
 
   if ((queue = malloc(sizeof(*queue)))) {
+    addMemoryUsage(MEMORY_QUEUES, sizeof(*queue));
     queue->head = NULL;
     queue->size = 0;
     queue->data = NULL;
     queue->deallocateItem = deallocateItem;
     queue->compareItems = compareItems;
+
+    queue->pool.elements = NULL;
+    queue->pool.count = 0;
+
     return queue;
   } else {
     logMallocError();
@@ -300,6 +375,14 @@ deleteElements (Queue *queue) {
 void
 deallocateQueue (Queue *queue) {
   deleteElements(queue);
+
+  if (queue->pool.elements) {
+    Element *last = queue->pool.elements;
+    while (last->next) last = last->next;
+    shareElements(queue->pool.elements, last);
+  }
+
+  subtractMemoryUsage(MEMORY_QUEUES, sizeof(*queue));
   free(queue);
 }
 
@@ -45,16 +45,35 @@
     internal[index] = characters[index]; \
   }
 
+/* When the internal character type is the same size as wchar_t then the
+ * text to be matched needn't be copied.
+ */
+#define RGX_TEXT_TO_INTERNAL \
+  const RGX_CharacterType *internal; \
+  int convert = sizeof(RGX_CharacterType) != sizeof(wchar_t); \
+  RGX_CharacterType buffer[convert? (length + 1): 1]; \
+  if (convert) { \
+    for (unsigned int index=0; index<length; index+=1) { \
+      buffer[index] = characters[index]; \
+    } \
+    buffer[length] = 0; \
+    internal = buffer; \
+  } else { \
+    internal = (const RGX_CharacterType *)characters; \
+  }
+
 struct RGX_ObjectStruct {
   void *data;
   Queue *matchers;
   RGX_OptionsType options;
+  RGX_ContextType *context;
 };
 
 struct RGX_MatcherStruct {
   void *data;
   RGX_MatchHandler *handler;
   RGX_OptionsType options;
+  RGX_ContextType *context;
 
   struct {
     wchar_t *characters;
@@ -115,6 +134,7 @@ rgxAddPatternCharacters (
     matcher->data = data;
     matcher->handler = handler;
     matcher->options = 0;
+    matcher->context = rgx->context;
 
     matcher->pattern.characters = calloc(
       (matcher->pattern.length = length) + 1,
@@ -134,7 +154,7 @@ rgxAddPatternCharacters (
       );
 
       if (matcher->compiled.code) {
-        matcher->compiled.data = rgxAllocateData(matcher->compiled.code);
+        matcher->compiled.data = rgxAllocateData(matcher->compiled.code, matcher->context);
 
         if (matcher->compiled.data) {
           if (enqueueItem(rgx->matchers, matcher)) {
@@ -191,7 +211,7 @@ rgxTestMatcher (const void *item, void *data) {
   int error;
   int matched = rgxMatchText(
     match->text.internal, match->text.length,
-    matcher->compiled.code, matcher->compiled.data,
+    matcher->compiled.code, matcher->compiled.data, matcher->context,
     matcher->options, &match->capture.count, &error
   );
 
@@ -216,11 +236,11 @@ rgxMatchTextCharacters (
   const wchar_t *characters, size_t length,
   RGX_Match **result, void *data
 ) {
-  RGX_CHARACTERS_TO_INTERNAL;
+  RGX_TEXT_TO_INTERNAL;
 
   RGX_Match match = {
     .text = {
-      .internal = internal,
+      .internal = (void *)internal,
       .characters = characters,
       .length = length
     },
@@ -353,8 +373,12 @@ rgxNewObject (void *data) {
     rgx->data = data;
     rgx->options = 0;
 
-    if ((rgx->matchers = newQueue(rgxDeallocateMatcher, NULL))) {
-      return rgx;
+    if ((rgx->context = rgxAllocateContext())) {
+      if ((rgx->matchers = newQueue(rgxDeallocateMatcher, NULL))) {
+        return rgx;
+      }
+
+      rgxDeallocateContext(rgx->context);
     }
 
     free(rgx);
@@ -368,6 +392,7 @@ rgxNewObject (void *data) {
 void
 rgxDestroyObject (RGX_Object *rgx) {
   deallocateQueue(rgx->matchers);
+  rgxDeallocateContext(rgx->context);
   free(rgx);
 }
 
@@ -24,12 +24,14 @@
 #if defined(USE_PKG_RGX_NONE)
 #define RGX_NO_MATCH 1
 #define RGX_NO_NAME 2
+#define RGX_NO_SUPPORT 3
 
 typedef wchar_t RGX_CharacterType;
 typedef size_t RGX_OffsetType;
 typedef int RGX_OptionsType;
 typedef uint8_t RGX_CodeType;
 typedef uint8_t RGX_DataType;
+typedef uint8_t RGX_ContextType;
 
 #elif defined(USE_PKG_RGX_LIBPCRE32)
 #include <pcre.h>
@@ -49,6 +51,10 @@ typedef struct {
   RGX_OffsetType offsets[];
 } RGX_DataType;
 
+typedef struct {
+  pcre32_jit_stack *stack;
+} RGX_ContextType;
+
 #elif defined(USE_PKG_RGX_LIBPCRE2_32)
 #define PCRE2_CODE_UNIT_WIDTH 32
 #include <pcre2.h>
@@ -62,14 +68,29 @@ typedef uint32_t RGX_OptionsType;
 typedef pcre2_code RGX_CodeType;
 typedef pcre2_match_data RGX_DataType;
 
+typedef struct {
+  pcre2_match_context *match;
+  pcre2_jit_stack *stack;
+} RGX_ContextType;
+
 #else /* regular expression package */
 #error regular expression package not selected
 #endif /* regular expression package */
 
+/* Patterns are JIT compiled when the package supports it. The JIT stack,
+ * which starts small and grows as needed, belongs to the object so that all
+ * of its matchers can share it.
+ */
+#define RGX_JIT_STACK_INITIAL 0X8000
+#define RGX_JIT_STACK_MAXIMUM 0X80000
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+extern RGX_ContextType *rgxAllocateContext (void);
+extern void rgxDeallocateContext (RGX_ContextType *context);
+
 extern RGX_CodeType *rgxCompilePattern (
   const RGX_CharacterType *characters, size_t length,
   RGX_OptionsType options, RGX_OffsetType *offset,
@@ -77,12 +98,12 @@ extern RGX_CodeType *rgxCompilePattern (
 );
 
 extern void rgxDeallocateCode (RGX_CodeType *code);
-extern RGX_DataType *rgxAllocateData (RGX_CodeType *code);
+extern RGX_DataType *rgxAllocateData (RGX_CodeType *code, RGX_ContextType *context);
 extern void rgxDeallocateData (RGX_DataType *data);
 
 extern int rgxMatchText (
   const RGX_CharacterType *characters, size_t length,
-  RGX_CodeType *code, RGX_DataType *data,
+  RGX_CodeType *code, RGX_DataType *data, RGX_ContextType *context,
   RGX_OptionsType options, size_t *count, int *error
 );
 
@@ -18,19 +18,63 @@
 
 #include "prologue.h"
 
+#include <string.h>
+
+#include "log.h"
 #include "rgx.h"
 #include "rgx_internal.h"
 #include "strfmt.h"
 
+RGX_ContextType *
+rgxAllocateContext (void) {
+  RGX_ContextType *context;
+
+  if ((context = malloc(sizeof(*context)))) {
+    memset(context, 0, sizeof(*context));
+
+    if ((context->match = pcre2_match_context_create(NULL))) {
+      /* without its own stack, JIT code uses a small one on the machine stack */
+      if ((context->stack = pcre2_jit_stack_create(RGX_JIT_STACK_INITIAL, RGX_JIT_STACK_MAXIMUM, NULL))) {
+        pcre2_jit_stack_assign(context->match, NULL, context->stack);
+      }
+
+      return context;
+    }
+
+    free(context);
+  }
+
+  logMallocError();
+  return NULL;
+}
+
+void
+rgxDeallocateContext (RGX_ContextType *context) {
+  if (context->stack) pcre2_jit_stack_free(context->stack);
+  pcre2_match_context_free(context->match);
+  free(context);
+}
+
 RGX_CodeType *
 rgxCompilePattern (
   const RGX_CharacterType *characters, size_t length,
   RGX_OptionsType options, RGX_OffsetType *offset,
   int *error
 ) {
-  return pcre2_compile(
+  RGX_CodeType *code = pcre2_compile(
     characters, length, options, error, offset, NULL
   );
+
+  if (code) {
+    /* If JIT isn't available then matching just falls back to the interpreter. */
+    int result = pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+
+    if ((result < 0) && (result != PCRE2_ERROR_JIT_BADOPTION)) {
+      logMessage(LOG_DEBUG, "pcre2 JIT compile error: %d", result);
+    }
+  }
+
+  return code;
 }
 
 void
@@ -39,7 +83,7 @@ rgxDeallocateCode (RGX_CodeType *code) {
 }
 
 RGX_DataType *
-rgxAllocateData (RGX_CodeType *code) {
+rgxAllocateData (RGX_CodeType *code, RGX_ContextType *context) {
   return pcre2_match_data_create_from_pattern(code, NULL);
 }
 
@@ -51,11 +95,11 @@ rgxDeallocateData (RGX_DataType *data) {
 int
 rgxMatchText (
   const RGX_CharacterType *characters, size_t length,
-  RGX_CodeType *code, RGX_DataType *data,
+  RGX_CodeType *code, RGX_DataType *data, RGX_ContextType *context,
   RGX_OptionsType options, size_t *count, int *error
 ) {
   int result = pcre2_match(
-    code, characters, length, 0, options, data, NULL
+    code, characters, length, 0, options, data, context->match
   );
 
   if (result < 0) {
@@ -42,6 +42,29 @@ getErrorMessage (int error) {
   return NULL;
 }
 
+RGX_ContextType *
+rgxAllocateContext (void) {
+  RGX_ContextType *context;
+
+  if ((context = malloc(sizeof(*context)))) {
+    memset(context, 0, sizeof(*context));
+
+    /* without its own stack, JIT code uses a small one on the machine stack */
+    context->stack = pcre32_jit_stack_alloc(RGX_JIT_STACK_INITIAL, RGX_JIT_STACK_MAXIMUM);
+
+    return context;
+  }
+
+  logMallocError();
+  return NULL;
+}
+
+void
+rgxDeallocateContext (RGX_ContextType *context) {
+  if (context->stack) pcre32_jit_stack_free(context->stack);
+  free(context);
+}
+
 RGX_CodeType *
 rgxCompilePattern (
   const RGX_CharacterType *characters, size_t length,
@@ -64,7 +87,7 @@ rgxDeallocateCode (RGX_CodeType *code) {
 }
 
 RGX_DataType *
-rgxAllocateData (RGX_CodeType *code) {
+rgxAllocateData (RGX_CodeType *code, RGX_ContextType *context) {
   RGX_DataType *data;
   size_t size = sizeof(*data);
 
@@ -80,7 +103,7 @@ rgxAllocateData (RGX_CodeType *code) {
 
   {
     const char *message = NULL;
-    data->study = pcre32_study(code, 0, &message);
+    data->study = pcre32_study(code, PCRE_STUDY_JIT_COMPILE, &message);
 
     if (message) {
       logMessage(LOG_WARNING, "pcre study error: %s", message);
@@ -90,6 +113,10 @@ rgxAllocateData (RGX_CodeType *code) {
         data->study = NULL;
       }
     }
+
+    if (data->study && context->stack) {
+      pcre32_assign_jit_stack(data->study, NULL, context->stack);
+    }
   }
 
   return data;
@@ -104,7 +131,7 @@ rgxDeallocateData (RGX_DataType *data) {
 int
 rgxMatchText (
   const RGX_CharacterType *characters, size_t length,
-  RGX_CodeType *code, RGX_DataType *data,
+  RGX_CodeType *code, RGX_DataType *data, RGX_ContextType *context,
   RGX_OptionsType options, size_t *count, int *error
 ) {
   int result = pcre32_exec(
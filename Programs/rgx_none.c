@@ -22,12 +22,24 @@
 #include "rgx_internal.h"
 #include "strfmt.h"
 
+RGX_ContextType *
+rgxAllocateContext (void) {
+  static RGX_ContextType context;
+  return &context;
+}
+
+void
+rgxDeallocateContext (RGX_ContextType *context) {
+}
+
 RGX_CodeType *
 rgxCompilePattern (
   const RGX_CharacterType *characters, size_t length,
   RGX_OptionsType options, RGX_OffsetType *offset,
   int *error
 ) {
+  *offset = 0;
+  *error = RGX_NO_SUPPORT;
   return NULL;
 }
 
@@ -36,7 +48,7 @@ rgxDeallocateCode (RGX_CodeType *code) {
 }
 
 RGX_DataType *
-rgxAllocateData (RGX_CodeType *code) {
+rgxAllocateData (RGX_CodeType *code, RGX_ContextType *context) {
   return NULL;
 }
 
@@ -47,7 +59,7 @@ rgxDeallocateData (RGX_DataType *data) {
 int
 rgxMatchText (
   const RGX_CharacterType *characters, size_t length,
-  RGX_CodeType *code, RGX_DataType *data,
+  RGX_CodeType *code, RGX_DataType *data, RGX_ContextType *context,
   RGX_OptionsType options, size_t *count, int *error
 ) {
   *error = RGX_NO_MATCH;
@@ -75,6 +87,10 @@ STR_BEGIN_FORMATTER(rgxFormatErrorMessage, int error)
     case RGX_NO_MATCH:
       STR_PRINTF("no match");
       break;
+
+    case RGX_NO_SUPPORT:
+      STR_PRINTF("regular expression support not available");
+      break;
   }
 STR_END_FORMATTER
 
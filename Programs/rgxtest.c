@@ -0,0 +1,165 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+
+#include "log.h"
+#include "program.h"
+#include "options.h"
+#include "parse.h"
+#include "timing.h"
+#include "rgx.h"
+
+static char *opt_iterations;
+static int opt_anchorStart;
+
+BEGIN_OPTION_TABLE(programOptions)
+  { .word = "iterations",
+    .letter = 'i',
+    .argument = "count",
+    .setting.string = &opt_iterations,
+    .internal.setting = "10000",
+    .description = "the number of times to match each line"
+  },
+
+  { .word = "anchor",
+    .letter = 'a',
+    .setting.flag = &opt_anchorStart,
+    .description = "anchor the patterns at the start of each line (as prompt patterns are)"
+  },
+END_OPTION_TABLE
+
+/* patterns like the ones typically given via --prompt-patterns */
+static const char *const defaultPatterns[] = {
+  "[^ ]*[$#] ",
+  "\\[[^]]*\\][$#] ",
+  "[a-zA-Z]:\\\\[^>]*>",
+  ">>> ",
+  "\\(gdb\\) ",
+};
+
+/* a screenful of typical terminal output */
+static const wchar_t *const textLines[] = {
+  WS_C("user@host:~/src/brltty$ make -j4"),
+  WS_C("gcc -c -O2 -Wall -o core.o core.c"),
+  WS_C("gcc -c -O2 -Wall -o config.o config.c"),
+  WS_C("make[1]: Leaving directory '/home/user/src/brltty/Programs'"),
+  WS_C("[user@host brltty]# ls -l"),
+  WS_C("total 1024"),
+  WS_C("-rw-r--r-- 1 user user  4096 Jan  1 12:00 Makefile"),
+  WS_C("drwxr-xr-x 2 user user  4096 Jan  1 12:00 Programs"),
+  WS_C("C:\\Users\\user>dir"),
+  WS_C(" Volume in drive C has no label."),
+  WS_C(">>> import sys"),
+  WS_C(">>> print(sys.version)"),
+  WS_C("3.11.2 (main, Mar 13 2023, 12:18:29) [GCC 12.2.0]"),
+  WS_C("(gdb) break main"),
+  WS_C("Breakpoint 1 at 0x1139: file test.c, line 5."),
+  WS_C("(gdb) run"),
+  WS_C(""),
+  WS_C("The quick brown fox jumps over the lazy dog."),
+  WS_C("   indented text that doesn't look like a prompt at all"),
+  WS_C("error: expected ';' before '}' token"),
+  WS_C("user@host:~/src/brltty$ "),
+  WS_C("Press RETURN to continue, or q to quit"),
+  WS_C("--More--(42%)"),
+  WS_C("user@host:~$ "),
+};
+
+static RGX_Object *
+compilePatterns (const char *const *patterns, int count) {
+  RGX_Object *rgx = rgxNewObject(NULL);
+
+  if (rgx) {
+    if (opt_anchorStart) rgxCompileOption(rgx, RGX_OPTION_SET, RGX_COMPILE_ANCHOR_START);
+
+    TimeValue start;
+    getMonotonicTime(&start);
+
+    for (int index=0; index<count; index+=1) {
+      if (!rgxAddPatternUTF8(rgx, patterns[index], NULL, NULL)) {
+        rgxDestroyObject(rgx);
+        return NULL;
+      }
+    }
+
+    long int elapsed = getMonotonicElapsed(&start);
+    printf("compile: %d patterns in %ldms\n", count, elapsed);
+  }
+
+  return rgx;
+}
+
+static void
+benchmarkMatches (RGX_Object *rgx, int iterations) {
+  unsigned long int lines = 0;
+  unsigned long int matches = 0;
+
+  TimeValue start;
+  getMonotonicTime(&start);
+
+  for (int iteration=0; iteration<iterations; iteration+=1) {
+    for (unsigned int index=0; index<ARRAY_COUNT(textLines); index+=1) {
+      if (rgxMatchTextString(rgx, textLines[index], NULL, NULL)) matches += 1;
+      lines += 1;
+    }
+  }
+
+  long int elapsed = getMonotonicElapsed(&start);
+  unsigned long int rate = elapsed? ((lines * MSECS_PER_SEC) / elapsed): 0;
+
+  printf(
+    "match: %lu lines (%lu matched) in %ldms: %lu/s\n",
+    lines, matches, elapsed, rate
+  );
+}
+
+int
+main (int argc, char *argv[]) {
+  {
+    static const OptionsDescriptor descriptor = {
+      OPTION_TABLE(programOptions),
+      .applicationName = "rgxtest",
+      .argumentsSummary = "[pattern ...]"
+    };
+
+    PROCESS_OPTIONS(descriptor, argc, argv);
+  }
+
+  int iterations;
+
+  {
+    static const int minimum = 1;
+
+    if (!validateInteger(&iterations, opt_iterations, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid iteration count: %s", opt_iterations);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
+  RGX_Object *rgx = argc?
+    compilePatterns((const char *const *)argv, argc):
+    compilePatterns(defaultPatterns, ARRAY_COUNT(defaultPatterns));
+  if (!rgx) return PROG_EXIT_FATAL;
+
+  benchmarkMatches(rgx, iterations);
+  rgxDestroyObject(rgx);
+  return PROG_EXIT_SUCCESS;
+}
@@ -46,6 +46,34 @@ typedef enum {
   CRR_FAIL
 } RoutingResult;
 
+typedef enum {
+  CURSOR_AXIS_HORIZONTAL,
+  CURSOR_AXIS_VERTICAL,
+  CURSOR_AXIS_COUNT
+} CursorAxis;
+
+/* What has been learned about how a screen (and, therefore, usually the
+ * application running on it) responds to cursor motion keys. It's passed to
+ * the routing subprocess and then updated from the subprocess's report.
+ */
+typedef struct {
+  int screen;
+
+  struct {
+    long int sum;
+    int count;
+  } time;
+
+  unsigned char burst[CURSOR_AXIS_COUNT];
+} RoutingProfile;
+
+typedef struct {
+  RoutingProfile profile;
+  unsigned int keys;
+  unsigned int notifications;
+  long int duration;
+} RoutingReport;
+
 typedef struct {
 #ifdef SIGUSR1
   struct {
@@ -79,6 +107,17 @@ typedef struct {
     long sum;
     int count;
   } time;
+
+  struct {
+    unsigned char size[CURSOR_AXIS_COUNT];
+  } burst;
+
+  struct {
+    unsigned char monitored;
+    unsigned int count;
+  } update;
+
+  RoutingReport *report;
 } CursorRoutingData;
 
 typedef enum {
@@ -100,23 +139,21 @@ static const CursorDirectionEntry cursorDirectionTable[] = {
   [CURSOR_DIR_DOWN]  = {.name="down" , .key=SCR_KEY_CURSOR_DOWN }
 };
 
-typedef enum {
-  CURSOR_AXIS_HORIZONTAL,
-  CURSOR_AXIS_VERTICAL
-} CursorAxis;
-
 typedef struct {
+  CursorAxis axis;
   const CursorDirectionEntry *forward;
   const CursorDirectionEntry *backward;
 } CursorAxisEntry;
 
 static const CursorAxisEntry cursorAxisTable[] = {
   [CURSOR_AXIS_HORIZONTAL] = {
+    .axis = CURSOR_AXIS_HORIZONTAL,
     .forward  = &cursorDirectionTable[CURSOR_DIR_RIGHT],
     .backward = &cursorDirectionTable[CURSOR_DIR_LEFT]
   }
   ,
   [CURSOR_AXIS_VERTICAL] = {
+    .axis = CURSOR_AXIS_VERTICAL,
     .forward  = &cursorDirectionTable[CURSOR_DIR_DOWN],
     .backward = &cursorDirectionTable[CURSOR_DIR_UP]
   }
@@ -124,6 +161,47 @@ static const CursorAxisEntry cursorAxisTable[] = {
 
 #define logRouting(...) logMessage(LOG_CATEGORY(CURSOR_ROUTING), __VA_ARGS__)
 
+static volatile unsigned int screenUpdateCount = 0;
+
+void
+routingScreenUpdated (void) {
+  screenUpdateCount += 1;
+}
+
+static void
+monitorScreenUpdates (CursorRoutingData *crd) {
+  if (crd->update.monitored) {
+    crd->update.count = screenUpdateCount;
+
+    if (pollRoutingScreen()) {
+      logRouting("screen updates can't be monitored");
+      crd->update.monitored = 0;
+    }
+  }
+}
+
+ASYNC_CONDITION_TESTER(testScreenUpdated) {
+  const CursorRoutingData *crd = data;
+  return screenUpdateCount != crd->update.count;
+}
+
+static void
+awaitScreenUpdate (CursorRoutingData *crd, long int timeout) {
+  if (crd->update.monitored) {
+    /* still check now and then in case a notification is missed */
+    if (timeout > ROUTING_UPDATE_CHECK_INTERVAL) timeout = ROUTING_UPDATE_CHECK_INTERVAL;
+    if (timeout < 1) timeout = 1;
+
+    if (asyncAwaitCondition(timeout, testScreenUpdated, crd)) {
+      crd->report->notifications += 1;
+    }
+
+    monitorScreenUpdates(crd);
+  } else {
+    asyncWait(ROUTING_POLL_INTERVAL);
+  }
+}
+
 static int
 readRow (CursorRoutingData *crd, ScreenCharacter *buffer, int row) {
   if (!buffer) buffer = crd->vertical.buffer;
@@ -215,7 +293,7 @@ handleVerticalScrolling (CursorRoutingData *crd, int direction) {
 }
 
 static int
-awaitCursorMotion (CursorRoutingData *crd, int direction) {
+awaitCursorMotion (CursorRoutingData *crd, int direction, const CursorAxisEntry *axis, int expected) {
   crd->previous.column = crd->current.column;
   crd->previous.row = crd->current.row;
 
@@ -226,7 +304,7 @@ awaitCursorMotion (CursorRoutingData *crd, int direction) {
   long int timeout = crd->time.sum / crd->time.count;
 
   while (1) {
-    asyncWait(ROUTING_POLL_INTERVAL);
+    awaitScreenUpdate(crd, (timeout - getMonotonicElapsed(&start)));
 
     TimeValue now;
     getMonotonicTime(&now);
@@ -248,7 +326,21 @@ awaitCursorMotion (CursorRoutingData *crd, int direction) {
         crd->time.count += 1;
       }
 
-      if (ROUTING_POLL_INTERVAL) {
+      {
+        int rows = crd->current.row - crd->previous.row;
+        int columns = crd->current.column - crd->previous.column;
+        int distance = (axis->axis == CURSOR_AXIS_HORIZONTAL)? columns: rows;
+        int other = (axis->axis == CURSOR_AXIS_HORIZONTAL)? rows: columns;
+
+        /* The cursor has gone exactly where the keys should have taken it so
+         * there's no need to wait to see if it'll move any further.
+         */
+        if ((distance == (expected * direction)) && (!other || (axis->axis == CURSOR_AXIS_VERTICAL))) {
+          break;
+        }
+      }
+
+      if (ROUTING_POLL_INTERVAL || crd->update.monitored) {
         start = now;
       } else {
         asyncWait(1);
@@ -264,7 +356,7 @@ awaitCursorMotion (CursorRoutingData *crd, int direction) {
 }
 
 static int
-moveCursor (CursorRoutingData *crd, const CursorDirectionEntry *direction) {
+moveCursor (CursorRoutingData *crd, const CursorDirectionEntry *direction, int count) {
   crd->vertical.row = crd->current.row - crd->vertical.scroll;
   if (!readRow(crd, NULL, crd->vertical.row)) return 0;
 
@@ -273,8 +365,9 @@ moveCursor (CursorRoutingData *crd, const CursorDirectionEntry *direction) {
   sigprocmask(SIG_BLOCK, &crd->signal.mask, &oldMask);
 #endif /* SIGUSR1 */
 
-  logRouting("move: %s", direction->name);
-  insertScreenKey(direction->key);
+  logRouting("move: %s x%d", direction->name, count);
+  crd->report->keys += count;
+  while (count--) insertScreenKey(direction->key);
 
 #ifdef SIGUSR1
   sigprocmask(SIG_SETMASK, &oldMask, NULL);
@@ -283,9 +376,40 @@ moveCursor (CursorRoutingData *crd, const CursorDirectionEntry *direction) {
   return 1;
 }
 
+static int
+getBurstSize (const CursorRoutingData *crd, const CursorAxisEntry *axis, int distance) {
+  if (distance < 0) distance = -distance;
+
+  /* Never plan to overshoot the target - the keys can't be taken back. */
+  int size = crd->burst.size[axis->axis];
+  if (size >= distance) size = distance - 1;
+  if (size < 1) size = 1;
+  return size;
+}
+
+static void
+adjustBurstSize (CursorRoutingData *crd, const CursorAxisEntry *axis, int sent, int direction) {
+  unsigned char *size = &crd->burst.size[axis->axis];
+
+  int moved = (axis->axis == CURSOR_AXIS_HORIZONTAL)?
+              (crd->current.column - crd->previous.column):
+              (crd->current.row - crd->previous.row);
+
+  if (moved == (sent * direction)) {
+    /* each key moved the cursor exactly one position so send more of them */
+    if (*size < ROUTING_MAXIMUM_BURST) *size = MIN(*size * 2, ROUTING_MAXIMUM_BURST);
+  } else if (*size > 1) {
+    logRouting("burst reset: %s sent=%d moved=%d",
+               ((axis->axis == CURSOR_AXIS_HORIZONTAL)? "horizontal": "vertical"),
+               sent, moved);
+    *size = 1;
+  }
+}
+
 static RoutingResult
 adjustCursorPosition (CursorRoutingData *crd, int where, int trgy, int trgx, const CursorAxisEntry *axis) {
   logRouting("to: [%d,%d]", trgx, trgy);
+  int oneAtATime = 0;
 
   while (1) {
     int dify = trgy - crd->current.row;
@@ -302,8 +426,30 @@ adjustCursorPosition (CursorRoutingData *crd, int where, int trgy, int trgx, con
     }
 
     /* tell the cursor to move in the needed direction */
-    if (!moveCursor(crd, ((dir > 0)? axis->forward: axis->backward))) return CRR_FAIL;
-    if (!awaitCursorMotion(crd, dir)) return CRR_FAIL;
+    int count = oneAtATime? 1: getBurstSize(crd, axis, (dify? dify: difx));
+    if (!moveCursor(crd, ((dir > 0)? axis->forward: axis->backward), count)) return CRR_FAIL;
+    if (!awaitCursorMotion(crd, dir, axis, count)) return CRR_FAIL;
+    adjustBurstSize(crd, axis, count, dir);
+
+    if (count > 1) {
+      int overshot = dify?
+                     (((trgy - crd->current.row) * dify) < 0):
+                     ((crd->current.row != trgy) || (((trgx - crd->current.column) * difx) < 0));
+
+      if (overshot) {
+        /* Some of the keys (e.g. over tabs or wide characters) moved the
+         * cursor more than one position. Undo the whole burst and try again
+         * one key at a time so as to get as close as the keys allow.
+         */
+        logRouting("burst overshot: retrying one key at a time");
+        if (!moveCursor(crd, ((dir > 0)? axis->backward: axis->forward), count)) return CRR_FAIL;
+        if (!awaitCursorMotion(crd, -dir, axis, count)) return CRR_FAIL;
+
+        crd->burst.size[axis->axis] = 1;
+        oneAtATime = 1;
+        continue;
+      }
+    }
 
     if (crd->current.row != crd->previous.row) {
       if (crd->previous.row != trgy) {
@@ -338,10 +484,11 @@ adjustCursorPosition (CursorRoutingData *crd, int where, int trgy, int trgx, con
 
     /* We're getting farther from our target. Before giving up, let's
      * try going back to the previous position since it was obviously
-     * the nearest ever reached.
+     * the nearest ever reached (which, after a burst, is where the whole
+     * burst started).
      */
-    if (!moveCursor(crd, ((dir > 0)? axis->backward: axis->forward))) return CRR_FAIL;
-    return awaitCursorMotion(crd, -dir)? CRR_NEAR: CRR_FAIL;
+    if (!moveCursor(crd, ((dir > 0)? axis->backward: axis->forward), count)) return CRR_FAIL;
+    return awaitCursorMotion(crd, -dir, axis, count)? CRR_NEAR: CRR_FAIL;
   }
 }
 
@@ -359,12 +506,16 @@ typedef struct {
   int column;
   int row;
   int screen;
+  RoutingProfile profile;
 } RoutingParameters;
 
 static RoutingStatus
-routeCursor (const RoutingParameters *parameters) {
+routeCursor (const RoutingParameters *parameters, RoutingReport *report) {
   CursorRoutingData crd;
 
+  TimeValue start;
+  getMonotonicTime(&start);
+
 #ifdef SIGUSR1
   /* Set up the signal mask. */
   sigemptyset(&crd.signal.mask);
@@ -375,8 +526,18 @@ routeCursor (const RoutingParameters *parameters) {
   /* initialize the routing data structure */
   crd.screen.number = parameters->screen;
   crd.vertical.buffer = NULL;
-  crd.time.sum = ROUTING_MAXIMUM_TIMEOUT;
-  crd.time.count = 1;
+  crd.time.sum = parameters->profile.time.sum;
+  crd.time.count = parameters->profile.time.count;
+
+  for (CursorAxis axis=0; axis<CURSOR_AXIS_COUNT; axis+=1) {
+    crd.burst.size[axis] = parameters->profile.burst[axis];
+  }
+
+  crd.report = report;
+  memset(report, 0, sizeof(*report));
+
+  crd.update.monitored = 1;
+  monitorScreenUpdates(&crd);
 
   if (getCurrentPosition(&crd)) {
     logRouting("from: [%d,%d]", crd.current.column, crd.current.row);
@@ -398,16 +559,138 @@ routeCursor (const RoutingParameters *parameters) {
 
   if (crd.vertical.buffer) free(crd.vertical.buffer);
 
+  {
+    RoutingProfile *profile = &report->profile;
+
+    profile->screen = parameters->screen;
+    profile->time.sum = crd.time.sum;
+    profile->time.count = crd.time.count;
+
+    for (CursorAxis axis=0; axis<CURSOR_AXIS_COUNT; axis+=1) {
+      profile->burst[axis] = crd.burst.size[axis];
+    }
+
+    report->duration = getMonotonicElapsed(&start);
+  }
+
   if (crd.screen.number != parameters->screen) return ROUTING_STATUS_FAILURE;
   if (crd.current.row != parameters->row) return ROUTING_STATUS_ROW;
   if ((parameters->column >= 0) && (crd.current.column != parameters->column)) return ROUTING_STATUS_COLUMN;
   return ROUTING_STATUS_SUCCEESS;
 }
 
+static RoutingProfile routingProfiles[ROUTING_PROFILE_LIMIT];
+static unsigned int routingProfileCount = 0;
+
+static void
+getRoutingProfile (RoutingProfile *profile, int screen) {
+  for (unsigned int index=0; index<routingProfileCount; index+=1) {
+    if (routingProfiles[index].screen == screen) {
+      *profile = routingProfiles[index];
+      return;
+    }
+  }
+
+  memset(profile, 0, sizeof(*profile));
+  profile->screen = screen;
+  profile->time.sum = ROUTING_MAXIMUM_TIMEOUT;
+  profile->time.count = 1;
+
+  for (CursorAxis axis=0; axis<CURSOR_AXIS_COUNT; axis+=1) {
+    profile->burst[axis] = 1;
+  }
+}
+
+static void
+putRoutingProfile (const RoutingProfile *profile) {
+  unsigned int index = 0;
+
+  while (index < routingProfileCount) {
+    if (routingProfiles[index].screen == profile->screen) break;
+    index += 1;
+  }
+
+  if (index == routingProfileCount) {
+    if (routingProfileCount < ROUTING_PROFILE_LIMIT) {
+      routingProfileCount += 1;
+    } else {
+      index -= 1;
+    }
+  }
+
+  /* keep the most recently used profile first */
+  memmove(&routingProfiles[1], &routingProfiles[0], (index * sizeof(routingProfiles[0])));
+  routingProfiles[0] = *profile;
+
+  {
+    RoutingProfile *new = &routingProfiles[0];
+
+    /* weight the history so that it can still adapt to a change in load */
+    if (new->time.count > 8) {
+      new->time.sum = (new->time.sum * 8) / new->time.count;
+      new->time.count = 8;
+    }
+  }
+}
+
+typedef struct {
+  unsigned long int routings;
+  unsigned long int keys;
+  unsigned long int notifications;
+  long int totalTime;
+  long int maximumTime;
+  unsigned long int statuses[ROUTING_STATUS_FAILURE + 1];
+} RoutingStatistics;
+
+static RoutingStatistics routingStatistics;
+
+static void
+handleRoutingReport (const RoutingReport *report, RoutingStatus status) {
+  putRoutingProfile(&report->profile);
+
+  RoutingStatistics *rs = &routingStatistics;
+  rs->routings += 1;
+  rs->keys += report->keys;
+  rs->notifications += report->notifications;
+  rs->totalTime += report->duration;
+  if (report->duration > rs->maximumTime) rs->maximumTime = report->duration;
+  if (status < ARRAY_COUNT(rs->statuses)) rs->statuses[status] += 1;
+
+  logRouting(
+    "statistics: time=%ldms keys=%u updates=%u"
+    " timeout=%ldms burst=%u/%u"
+    " routings=%lu average=%ldms maximum=%ldms"
+    " succeeded=%lu wrong-column=%lu wrong-row=%lu failed=%lu",
+    report->duration, report->keys, report->notifications,
+    (report->profile.time.sum / report->profile.time.count),
+    report->profile.burst[CURSOR_AXIS_HORIZONTAL],
+    report->profile.burst[CURSOR_AXIS_VERTICAL],
+    rs->routings, (rs->totalTime / (long int)rs->routings), rs->maximumTime,
+    rs->statuses[ROUTING_STATUS_SUCCEESS], rs->statuses[ROUTING_STATUS_COLUMN],
+    rs->statuses[ROUTING_STATUS_ROW], rs->statuses[ROUTING_STATUS_FAILURE]
+  );
+}
+
 #ifdef SIGUSR1
 #define NOT_ROUTING 0
 
 static pid_t routingProcess = NOT_ROUTING;
+static int routingReportDescriptor = -1;
+
+static void
+readRoutingReport (RoutingStatus status) {
+  if (routingReportDescriptor != -1) {
+    RoutingReport report;
+
+    /* a stopped subprocess won't have written one */
+    if (read(routingReportDescriptor, &report, sizeof(report)) == sizeof(report)) {
+      handleRoutingReport(&report, status);
+    }
+
+    close(routingReportDescriptor);
+    routingReportDescriptor = -1;
+  }
+}
 
 int
 isRouting (void) {
@@ -426,8 +709,11 @@ getRoutingStatus (int wait) {
       pid_t process = waitpid(routingProcess, &status, options);
 
       if (process == routingProcess) {
+        RoutingStatus routingStatus = WIFEXITED(status)? WEXITSTATUS(status): ROUTING_STATUS_FAILURE;
+
         routingProcess = NOT_ROUTING;
-        return WIFEXITED(status)? WEXITSTATUS(status): ROUTING_STATUS_FAILURE;
+        readRoutingReport(routingStatus);
+        return routingStatus;
       }
 
       if (process == -1) {
@@ -435,6 +721,7 @@ getRoutingStatus (int wait) {
 
         if (errno == ECHILD) {
           routingProcess = NOT_ROUTING;
+          readRoutingReport(ROUTING_STATUS_FAILURE);
           return ROUTING_STATUS_FAILURE;
         }
 
@@ -478,12 +765,19 @@ static int
 startRoutingProcess (const RoutingParameters *parameters) {
 #ifdef SIGUSR1
   int started = 0;
+  int reportDescriptors[2];
 
   stopRouting();
 
+  if (pipe(reportDescriptors) == -1) {
+    logSystemError("pipe");
+    return 0;
+  }
+
   switch (routingProcess = fork()) {
     case 0: { /* child: cursor routing subprocess */
       RoutingStatus status = ROUTING_STATUS_FAILURE;
+      close(reportDescriptors[0]);
 
       if (!ROUTING_POLL_INTERVAL) {
         int niceness = nice(ROUTING_PROCESS_NICENESS);
@@ -494,8 +788,14 @@ startRoutingProcess (const RoutingParameters *parameters) {
       }
 
       if (constructRoutingScreen()) {
-        status = routeCursor(parameters);		/* terminate child process */
+        RoutingReport report;
+
+        status = routeCursor(parameters, &report);
         destructRoutingScreen();		/* close second thread of screen reading */
+
+        if (write(reportDescriptors[1], &report, sizeof(report)) == -1) {
+          logSystemError("write");
+        }
       }
 
       _exit(status);		/* terminate child process */
@@ -504,10 +804,14 @@ startRoutingProcess (const RoutingParameters *parameters) {
     case -1: /* error: fork() failed */
       logSystemError("fork");
       routingProcess = NOT_ROUTING;
+      close(reportDescriptors[0]);
+      close(reportDescriptors[1]);
       break;
 
     default: {
       /* parent: continue while cursor is being routed */
+      close(reportDescriptors[1]);
+      routingReportDescriptor = reportDescriptors[0];
 
       {
         static int first = 1;
@@ -525,7 +829,10 @@ startRoutingProcess (const RoutingParameters *parameters) {
 
   return started;
 #else /* SIGUSR1 */
-  routingStatus = routeCursor(parameters);
+  RoutingReport report;
+
+  routingStatus = routeCursor(parameters, &report);
+  handleRoutingReport(&report, routingStatus);
   return 1;
 #endif /* SIGUSR1 */
 }
@@ -547,12 +854,14 @@ THREAD_FUNCTION(runRoutingThread) {
 
 int
 startRouting (int column, int row, int screen) {
-  const RoutingParameters parameters = {
+  RoutingParameters parameters = {
     .column = column,
     .row = row,
     .screen = screen
   };
 
+  getRoutingProfile(&parameters.profile, screen);
+
 #ifdef GOT_PTHREADS
   int started = 0;
 
@@ -35,6 +35,7 @@ typedef enum {
 extern int startRouting (int column, int row, int screen);
 extern int isRouting (void);
 extern RoutingStatus getRoutingStatus (int wait);
+extern void routingScreenUpdated (void);
 
 #ifdef __cplusplus
 }
@@ -30,6 +30,8 @@
 #include "log.h"
 #include "unicode.h"
 #include "scr.h"
+#include "scr_index.h"
+#include "scr_cache.h"
 #include "scr_real.h"
 #include "driver.h"
 
@@ -91,6 +93,8 @@ pollScreen (void) {
 
 int
 refreshScreen (void) {
+  invalidateScreenIndex();
+  invalidateScreenCache();
   return currentScreen->refresh();
 }
 
@@ -100,19 +104,12 @@ describeScreen (ScreenDescription *description) {
   if (description->unreadable) description->quality = SCQ_NONE;
 }
 
-int
-readScreen (short left, short top, short width, short height, ScreenCharacter *buffer) {
-  const ScreenBox box = {
-    .left = left,
-    .top = top,
-    .width = width,
-    .height = height,
-  };
-
-  if (!currentScreen->readCharacters(&box, buffer)) return 0;
+static int
+readScreenCharacters (const ScreenBox *box, ScreenCharacter *buffer) {
+  if (!currentScreen->readCharacters(box, buffer)) return 0;
 
   ScreenCharacter *character = buffer;
-  const ScreenCharacter *end = character + (box.width * box.height);
+  const ScreenCharacter *end = character + (box->width * box->height);
 
   while (character < end) {
     wchar_t *text = &character->text;
@@ -121,8 +118,8 @@ readScreen (short left, short top, short width, short height, ScreenCharacter *b
       // This is not a valid Unicode character - return the replacement character.
 
       size_t index = character - buffer;
-      unsigned int column = box.left + (index % box.width);
-      unsigned int row = box.top + (index / box.width);
+      unsigned int column = box->left + (index % box->width);
+      unsigned int row = box->top + (index / box->width);
 
       logMessage(LOG_ERR,
         "invalid character U+%04lX on screen at [%u,%u]",
@@ -138,6 +135,19 @@ readScreen (short left, short top, short width, short height, ScreenCharacter *b
   return 1;
 }
 
+int
+readScreen (short left, short top, short width, short height, ScreenCharacter *buffer) {
+  const ScreenBox box = {
+    .left = left,
+    .top = top,
+    .width = width,
+    .height = height,
+  };
+
+  if (isMainScreen()) return readCachedScreen(&box, buffer, readScreenCharacters);
+  return readScreenCharacters(&box, buffer);
+}
+
 int
 readScreenText (short left, short top, short width, short height, wchar_t *buffer) {
   unsigned int count = width * height;
@@ -247,6 +257,12 @@ constructRoutingScreen (void) {
    * in the main thread.  So we close and reopen the device.
    */
   mainScreen.destruct();
+
+  /* The main thread refreshes the screen, so this process would only ever
+   * see what was on it when it was forked.
+   */
+  disableScreenCache();
+
   return mainScreen.construct();
 }
 
@@ -255,3 +271,8 @@ destructRoutingScreen (void) {
   mainScreen.destruct();
   mainScreen.releaseParameters();
 }
+
+int
+pollRoutingScreen (void) {
+  return mainScreen.base.poll();
+}
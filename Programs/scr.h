@@ -68,6 +68,7 @@ readScreenRow (int row, int width, ScreenCharacter *buffer) {
  */
 extern int constructRoutingScreen (void);
 extern void destructRoutingScreen (void);
+extern int pollRoutingScreen (void);
 
 extern const ScreenDriver *screen;
 extern const ScreenDriver noScreen;
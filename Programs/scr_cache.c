@@ -0,0 +1,236 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "program.h"
+#include "memusage.h"
+#include "scr.h"
+#include "scr_cache.h"
+
+/* Rather than clearing a flag for each row when the cache is invalidated,
+ * the generation is advanced. A row is current if it was fetched during
+ * the current generation.
+ */
+typedef unsigned int ScreenCacheGeneration;
+
+static struct {
+  unsigned char isDisabled:1;
+  unsigned char exitRegistered:1;
+
+  ScreenCacheGeneration generation;
+  ScreenCacheGeneration describedGeneration;
+
+  int columns;
+  int rows;
+
+  ScreenCharacter *characters;
+  ScreenCacheGeneration *rowGenerations;
+
+  size_t memoryUsage;
+
+  struct {
+    unsigned long int hits;
+    unsigned long int misses;
+    unsigned long int bypasses;
+    unsigned long int generations;
+  } statistics;
+} screenCache = {
+  .generation = 1,
+};
+
+static void
+logScreenCacheStatistics (void) {
+  logMessage(LOG_CATEGORY(SCREEN_DRIVER),
+    "screen cache: Generations:%lu Hits:%lu Misses:%lu Bypasses:%lu",
+    screenCache.statistics.generations,
+    screenCache.statistics.hits,
+    screenCache.statistics.misses,
+    screenCache.statistics.bypasses
+  );
+}
+
+static void
+deallocateScreenCache (void) {
+  if (screenCache.characters) {
+    free(screenCache.characters);
+    screenCache.characters = NULL;
+  }
+
+  if (screenCache.rowGenerations) {
+    free(screenCache.rowGenerations);
+    screenCache.rowGenerations = NULL;
+  }
+
+  screenCache.columns = 0;
+  screenCache.rows = 0;
+  updateMemoryUsage(MEMORY_SCREEN_CACHES, &screenCache.memoryUsage, 0);
+}
+
+static void
+exitScreenCache (void *data) {
+  logScreenCacheStatistics();
+  deallocateScreenCache();
+}
+
+static int
+allocateScreenCache (int columns, int rows) {
+  if ((columns == screenCache.columns) && (rows == screenCache.rows)) return 1;
+  deallocateScreenCache();
+
+  size_t count = columns * rows;
+  if (!count) return 0;
+
+  if ((screenCache.characters = malloc(ARRAY_SIZE(screenCache.characters, count)))) {
+    if ((screenCache.rowGenerations = calloc(rows, sizeof(*screenCache.rowGenerations)))) {
+      screenCache.columns = columns;
+      screenCache.rows = rows;
+
+      updateMemoryUsage(
+        MEMORY_SCREEN_CACHES, &screenCache.memoryUsage,
+        (ARRAY_SIZE(screenCache.characters, count) +
+         ARRAY_SIZE(screenCache.rowGenerations, rows))
+      );
+
+      if (!screenCache.exitRegistered) {
+        onProgramExit("screen-cache", exitScreenCache, NULL);
+        screenCache.exitRegistered = 1;
+      }
+
+      return 1;
+    }
+  }
+
+  logMallocError();
+  deallocateScreenCache();
+  return 0;
+}
+
+static void
+forgetScreenCacheRows (void) {
+  if (screenCache.rowGenerations) {
+    memset(
+      screenCache.rowGenerations, 0,
+      ARRAY_SIZE(screenCache.rowGenerations, screenCache.rows)
+    );
+  }
+}
+
+static int
+prepareScreenCache (void) {
+  if (screenCache.isDisabled) return 0;
+  if (screenCache.describedGeneration == screenCache.generation) return !!screenCache.characters;
+
+  ScreenDescription description;
+  describeScreen(&description);
+  screenCache.describedGeneration = screenCache.generation;
+
+  if (description.unreadable) {
+    deallocateScreenCache();
+    return 0;
+  }
+
+  return allocateScreenCache(description.cols, description.rows);
+}
+
+void
+invalidateScreenCache (void) {
+  if (!(screenCache.generation += 1)) {
+    // wrapped - the row stamps from long ago mustn't look current
+    forgetScreenCacheRows();
+    screenCache.generation = 1;
+  }
+
+  screenCache.statistics.generations += 1;
+}
+
+void
+disableScreenCache (void) {
+  screenCache.isDisabled = 1;
+  deallocateScreenCache();
+}
+
+static int
+fetchScreenCacheRows (int top, int count, ScreenCacheReader *readScreenCharacters) {
+  const ScreenBox box = {
+    .left = 0,
+    .top = top,
+    .width = screenCache.columns,
+    .height = count,
+  };
+
+  ScreenCharacter *buffer = &screenCache.characters[top * screenCache.columns];
+  if (!readScreenCharacters(&box, buffer)) return 0;
+
+  ScreenCacheGeneration *generation = &screenCache.rowGenerations[top];
+  const ScreenCacheGeneration *end = generation + count;
+  while (generation < end) *generation++ = screenCache.generation;
+
+  screenCache.statistics.misses += count;
+  return 1;
+}
+
+int
+readCachedScreen (
+  const ScreenBox *box, ScreenCharacter *buffer,
+  ScreenCacheReader *readScreenCharacters
+) {
+  if (prepareScreenCache()) {
+    if ((box->left >= 0) && (box->width >= 0) && ((box->left + box->width) <= screenCache.columns) &&
+        (box->top >= 0) && (box->height >= 0) && ((box->top + box->height) <= screenCache.rows)) {
+      int bottom = box->top + box->height;
+      int row = box->top;
+
+      while (row < bottom) {
+        if (screenCache.rowGenerations[row] == screenCache.generation) {
+          screenCache.statistics.hits += 1;
+          row += 1;
+          continue;
+        }
+
+        // fetch consecutive stale rows with a single driver request
+        int first = row;
+        do {
+          row += 1;
+        } while ((row < bottom) && (screenCache.rowGenerations[row] != screenCache.generation));
+
+        if (!fetchScreenCacheRows(first, row-first, readScreenCharacters)) return 0;
+      }
+
+      {
+        const ScreenCharacter *from = &screenCache.characters[(box->top * screenCache.columns) + box->left];
+        int height = box->height;
+
+        while (height > 0) {
+          memcpy(buffer, from, ARRAY_SIZE(buffer, box->width));
+          buffer += box->width;
+          from += screenCache.columns;
+          height -= 1;
+        }
+      }
+
+      return 1;
+    }
+  }
+
+  screenCache.statistics.bypasses += 1;
+  return readScreenCharacters(box, buffer);
+}
@@ -0,0 +1,48 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_SCR_CACHE
+#define BRLTTY_INCLUDED_SCR_CACHE
+
+#include "scr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* A copy of the rows of the main screen which have been read since its last
+ * refresh. Each row is fetched from the screen driver the first time any
+ * reader asks for it, and all further reads of it are served from the copy,
+ * until the cache is invalidated (on refresh, when the current screen
+ * changes, or when the driver reports an update).
+ */
+typedef int ScreenCacheReader (const ScreenBox *box, ScreenCharacter *buffer);
+
+extern void invalidateScreenCache (void);
+extern void disableScreenCache (void);
+
+extern int readCachedScreen (
+  const ScreenBox *box, ScreenCharacter *buffer,
+  ScreenCacheReader *readScreenCharacters
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_SCR_CACHE */
@@ -117,6 +117,7 @@ createScreenSegment (int *id, key_t key, int columns, int rows) {
       segment->screenNumber = 0;
       segment->commonFlags = 0;
       segment->privateFlags = 0;
+      segment->updateNumber = 0;
 
       {
         ScreenSegmentCharacter *from = getScreenStart(segment);
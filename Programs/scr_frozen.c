@@ -28,10 +28,17 @@
 #include "alert.h"
 #include "scr.h"
 #include "scr_frozen.h"
+#include "scrollback.h"
 
 static ScreenDescription screenDescription;
 static ScreenCharacter *screenCharacters;
 
+/* The rows which have scrolled off the top of the screen are placed above
+ * the ones which were visible when it was frozen. They're read from the
+ * scrollback as they're needed since it doesn't change while frozen.
+ */
+static int scrollbackRows;
+
 static int startFreezeReminderAlarm (void);
 static AsyncHandle freezeReminderAlarm = NULL;
 
@@ -70,6 +77,10 @@ construct_FrozenScreen (BaseScreen *source) {
     };
 
     if (source->readCharacters(&box, screenCharacters)) {
+      scrollbackRows = getScrollbackRowCount(screenDescription.number);
+      screenDescription.rows += scrollbackRows;
+      if (screenDescription.posy >= 0) screenDescription.posy += scrollbackRows;
+
       startFreezeReminderAlarm();
       return 1;
     }
@@ -86,6 +97,7 @@ construct_FrozenScreen (BaseScreen *source) {
 static void
 destruct_FrozenScreen (void) {
   stopFreezeReminderAlarm();
+  scrollbackRows = 0;
 
   if (screenCharacters) {
     free(screenCharacters);
@@ -103,9 +115,18 @@ readCharacters_FrozenScreen (const ScreenBox *box, ScreenCharacter *buffer) {
   if (validateScreenBox(box, screenDescription.cols, screenDescription.rows)) {
     int row;
     for (row=0; row<box->height; row++) {
-      memcpy(&buffer[row * box->width],
-             &screenCharacters[((box->top + row) * screenDescription.cols) + box->left],
-             box->width * sizeof(*screenCharacters));
+      int top = box->top + row;
+      ScreenCharacter *to = &buffer[row * box->width];
+
+      if (top < scrollbackRows) {
+        if (!readScrollbackRow(screenDescription.number, top, box->left, box->width, to)) {
+          return 0;
+        }
+      } else {
+        memcpy(to,
+               &screenCharacters[((top - scrollbackRows) * screenDescription.cols) + box->left],
+               box->width * sizeof(*screenCharacters));
+      }
     }
     return 1;
   }
@@ -126,4 +147,5 @@ initializeFrozenScreen (FrozenScreen *frozen) {
   frozen->construct = construct_FrozenScreen;
   frozen->destruct = destruct_FrozenScreen;
   screenCharacters = NULL;
+  scrollbackRows = 0;
 }
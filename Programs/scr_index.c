@@ -0,0 +1,393 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+#include <wctype.h>
+
+#include "log.h"
+#include "program.h"
+#include "memusage.h"
+#include "scr.h"
+#include "scr_index.h"
+
+/* Each row has a summary of which characters, and which pairs of adjacent
+ * characters, it contains so that a search can skip the rows which can't
+ * possibly contain what it's looking for without looking at them. The
+ * characters are hashed into the bits of a mask so, while a clear bit is
+ * conclusive, a set bit only means that the row might match.
+ */
+
+typedef uint64_t ScreenTextMask;
+
+typedef struct {
+  ScreenTextMask characters;
+  ScreenTextMask digrams;
+} ScreenTextSummary;
+
+typedef struct {
+  ScreenTextSummary summary;
+  int indent;
+  unsigned char isBlank:1;
+} ScreenRowEntry;
+
+static struct {
+  unsigned char isValid:1;
+  unsigned char exitRegistered:1;
+
+  int columns;
+  int rows;
+
+  ScreenCharacter *characters;
+  wchar_t *text;
+  ScreenRowEntry *rowEntries;
+
+  size_t memoryUsage;
+} screenIndex = {
+  .isValid = 0,
+};
+
+static inline ScreenTextMask
+getCharacterBit (wchar_t character) {
+  return UINT64_C(1) << (character & 0X3F);
+}
+
+static inline ScreenTextMask
+getDigramBit (wchar_t character1, wchar_t character2) {
+  uint32_t hash = ((uint32_t)character1 * 31) + (uint32_t)character2;
+  return UINT64_C(1) << ((hash * UINT32_C(0X9E3779B1)) >> 26);
+}
+
+static void
+summarizeText (ScreenTextSummary *summary, const wchar_t *text, size_t count) {
+  summary->characters = 0;
+  summary->digrams = 0;
+
+  for (size_t index=0; index<count; index+=1) {
+    summary->characters |= getCharacterBit(text[index]);
+    if (index > 0) summary->digrams |= getDigramBit(text[index-1], text[index]);
+  }
+}
+
+static inline int
+mightContainText (const ScreenTextSummary *row, const ScreenTextSummary *text) {
+  if ((row->characters & text->characters) != text->characters) return 0;
+  if ((row->digrams & text->digrams) != text->digrams) return 0;
+  return 1;
+}
+
+static void
+foldText (wchar_t *text, size_t count) {
+  for (size_t index=0; index<count; index+=1) {
+    text[index] = towlower(text[index]);
+  }
+}
+
+static void
+deallocateScreenIndex (void) {
+  if (screenIndex.characters) {
+    free(screenIndex.characters);
+    screenIndex.characters = NULL;
+  }
+
+  if (screenIndex.text) {
+    free(screenIndex.text);
+    screenIndex.text = NULL;
+  }
+
+  if (screenIndex.rowEntries) {
+    free(screenIndex.rowEntries);
+    screenIndex.rowEntries = NULL;
+  }
+
+  screenIndex.columns = 0;
+  screenIndex.rows = 0;
+  screenIndex.isValid = 0;
+  updateMemoryUsage(MEMORY_SCREEN_CACHES, &screenIndex.memoryUsage, 0);
+}
+
+static void
+exitScreenIndex (void *data) {
+  deallocateScreenIndex();
+}
+
+static int
+allocateScreenIndex (int columns, int rows) {
+  if ((columns == screenIndex.columns) && (rows == screenIndex.rows)) return 1;
+  deallocateScreenIndex();
+
+  size_t count = columns * rows;
+  if (!count) return 0;
+
+  if ((screenIndex.characters = malloc(ARRAY_SIZE(screenIndex.characters, count)))) {
+    if ((screenIndex.text = malloc(ARRAY_SIZE(screenIndex.text, count)))) {
+      if ((screenIndex.rowEntries = malloc(ARRAY_SIZE(screenIndex.rowEntries, rows)))) {
+        screenIndex.columns = columns;
+        screenIndex.rows = rows;
+
+        updateMemoryUsage(
+          MEMORY_SCREEN_CACHES, &screenIndex.memoryUsage,
+          (ARRAY_SIZE(screenIndex.characters, count) +
+           ARRAY_SIZE(screenIndex.text, count) +
+           ARRAY_SIZE(screenIndex.rowEntries, rows))
+        );
+
+        if (!screenIndex.exitRegistered) {
+          onProgramExit("screen-index", exitScreenIndex, NULL);
+          screenIndex.exitRegistered = 1;
+        }
+
+        return 1;
+      }
+    }
+  }
+
+  logMallocError();
+  deallocateScreenIndex();
+  return 0;
+}
+
+static void
+indexScreenRow (int row) {
+  const ScreenCharacter *character = &screenIndex.characters[row * screenIndex.columns];
+  wchar_t *text = &screenIndex.text[row * screenIndex.columns];
+  ScreenRowEntry *entry = &screenIndex.rowEntries[row];
+
+  entry->indent = -1;
+  entry->isBlank = 1;
+
+  for (int column=0; column<screenIndex.columns; column+=1) {
+    wchar_t wc = character[column].text;
+    text[column] = wc;
+
+    if (wc != WC_C(' ')) {
+      if (entry->indent < 0) entry->indent = column;
+      if (entry->isBlank && !iswspace(wc)) entry->isBlank = 0;
+    }
+  }
+
+  foldText(text, screenIndex.columns);
+  summarizeText(&entry->summary, text, screenIndex.columns);
+}
+
+static int
+prepareScreenIndex (void) {
+  if (screenIndex.isValid) return 1;
+
+  ScreenDescription description;
+  describeScreen(&description);
+  if (description.unreadable) return 0;
+
+  if (!allocateScreenIndex(description.cols, description.rows)) return 0;
+
+  if (!readScreen(0, 0, screenIndex.columns, screenIndex.rows, screenIndex.characters)) {
+    return 0;
+  }
+
+  for (int row=0; row<screenIndex.rows; row+=1) indexScreenRow(row);
+  screenIndex.isValid = 1;
+  return 1;
+}
+
+void
+invalidateScreenIndex (void) {
+  screenIndex.isValid = 0;
+}
+
+int
+readIndexedScreen (short left, short top, short width, short height, ScreenCharacter *buffer) {
+  if (prepareScreenIndex()) {
+    if ((left >= 0) && (width >= 0) && ((left + width) <= screenIndex.columns) &&
+        (top >= 0) && (height >= 0) && ((top + height) <= screenIndex.rows)) {
+      const ScreenCharacter *from = &screenIndex.characters[(top * screenIndex.columns) + left];
+
+      while (height > 0) {
+        memcpy(buffer, from, ARRAY_SIZE(buffer, width));
+        buffer += width;
+        from += screenIndex.columns;
+        height -= 1;
+      }
+
+      return 1;
+    }
+  }
+
+  return readScreen(left, top, width, height, buffer);
+}
+
+static const ScreenRowEntry *
+getScreenRowEntry (int row) {
+  if (!prepareScreenIndex()) return NULL;
+  if (row < 0) return NULL;
+  if (row >= screenIndex.rows) return NULL;
+  return &screenIndex.rowEntries[row];
+}
+
+int
+getScreenRowIndent (int row) {
+  {
+    const ScreenRowEntry *entry = getScreenRowEntry(row);
+    if (entry) return entry->indent;
+  }
+
+  ScreenDescription description;
+  describeScreen(&description);
+
+  int width = description.cols;
+  ScreenCharacter characters[width];
+  if (!readScreenRow(row, width, characters)) return -1;
+
+  for (int column=0; column<width; column+=1) {
+    if (characters[column].text != WC_C(' ')) return column;
+  }
+
+  return -1;
+}
+
+int
+isBlankScreenRow (int row) {
+  {
+    const ScreenRowEntry *entry = getScreenRowEntry(row);
+    if (entry) return entry->isBlank;
+  }
+
+  ScreenDescription description;
+  describeScreen(&description);
+
+  int width = description.cols;
+  ScreenCharacter characters[width];
+  if (!readScreenRow(row, width, characters)) return 1;
+
+  for (int column=0; column<width; column+=1) {
+    if (!iswspace(characters[column].text)) return 0;
+  }
+
+  return 1;
+}
+
+static int
+findTextInRow (
+  const wchar_t *text, int from, int to,
+  const wchar_t *characters, size_t count, int last
+) {
+  const wchar_t *address = text + from;
+  size_t length = to - from;
+  int found = -1;
+
+  while (count <= length) {
+    const wchar_t *next = wmemchr(address, *characters, length);
+    if (!next) break;
+
+    length -= next - address;
+    address = next;
+    if (count > length) break;
+
+    if (wmemcmp(address, characters, count) == 0) {
+      found = address - text;
+      if (!last) break;
+    }
+
+    address += 1;
+    length -= 1;
+  }
+
+  return found;
+}
+
+int
+findScreenText (
+  const wchar_t *characters, size_t count,
+  int *column, int *row, int increment, int last
+) {
+  if (!count) return 0;
+
+  wchar_t pattern[count];
+  wmemcpy(pattern, characters, count);
+  foldText(pattern, count);
+
+  ScreenTextSummary summary;
+  summarizeText(&summary, pattern, count);
+
+  int indexed = prepareScreenIndex();
+  int columns;
+  int rows;
+
+  if (indexed) {
+    columns = screenIndex.columns;
+    rows = screenIndex.rows;
+  } else {
+    ScreenDescription description;
+    describeScreen(&description);
+
+    columns = description.cols;
+    rows = description.rows;
+  }
+
+  if (count > columns) return 0;
+  if (last >= rows) last = rows - 1;
+
+  int backward = increment < 0;
+  int current = *row;
+  int first = 1;
+  wchar_t buffer[columns];
+
+  while ((current >= 0) && (current <= last)) {
+    const wchar_t *text;
+
+    if (indexed) {
+      if (!mightContainText(&screenIndex.rowEntries[current].summary, &summary)) goto next;
+      text = &screenIndex.text[current * columns];
+    } else {
+      if (!readScreenText(0, current, columns, 1, buffer)) return 0;
+      foldText(buffer, columns);
+      text = buffer;
+    }
+
+    {
+      int from = 0;
+      int to = columns;
+
+      if (first) {
+        if (backward) {
+          int end = *column + count - 1;
+          if (end < to) to = end;
+        } else {
+          from = *column;
+          if (from > to) from = to;
+        }
+      }
+
+      if (from < to) {
+        int found = findTextInRow(text, from, to, pattern, count, backward);
+
+        if (found >= 0) {
+          *column = found;
+          *row = current;
+          return 1;
+        }
+      }
+    }
+
+  next:
+    first = 0;
+    current += increment;
+  }
+
+  return 0;
+}
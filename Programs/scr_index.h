@@ -0,0 +1,64 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_SCR_INDEX
+#define BRLTTY_INCLUDED_SCR_INDEX
+
+#include "scr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* A snapshot of the whole current screen, taken the first time it's needed
+ * after each refresh, which the navigation and search commands share so that
+ * they needn't go back to the screen driver for every row they look at.
+ */
+extern void invalidateScreenIndex (void);
+
+extern int readIndexedScreen (short left, short top, short width, short height, ScreenCharacter *buffer);
+
+static inline int
+readIndexedScreenRow (int row, int width, ScreenCharacter *buffer) {
+  return readIndexedScreen(0, row, width, 1, buffer);
+}
+
+/* the column of the first non-space character (-1 if there isn't one) */
+extern int getScreenRowIndent (int row);
+
+/* whether or not the row only contains white space */
+extern int isBlankScreenRow (int row);
+
+/* Case-insensitively find text on the screen, starting on the given row and
+ * moving by increment. Whatever the direction, only rows 0 through last (or
+ * the bottom of the screen if that's sooner) are searched, so a forward
+ * search stops after last and a backward one after row 0. On the starting
+ * row, a forward search only considers matches which begin at or after the
+ * given column and a backward search only those which begin before it. The
+ * row and column of the match are returned.
+ */
+extern int findScreenText (
+  const wchar_t *characters, size_t count,
+  int *column, int *row, int increment, int last
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_SCR_INDEX */
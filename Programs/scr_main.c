@@ -24,6 +24,9 @@
 #include "update.h"
 #include "scr.h"
 #include "scr_main.h"
+#include "scr_index.h"
+#include "scr_cache.h"
+#include "routing.h"
 
 static int
 poll_MainScreen (void) {
@@ -69,6 +72,10 @@ initializeMainScreen (MainScreen *main) {
 
 void
 mainScreenUpdated (void) {
+  routingScreenUpdated();
+  invalidateScreenIndex();
+  invalidateScreenCache();
+
   if (isMainScreen()) {
     scheduleUpdateIn("main screen updated", SCREEN_UPDATE_SCHEDULE_DELAY);
   }
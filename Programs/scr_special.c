@@ -28,6 +28,8 @@
 #include "log.h"
 #include "scr.h"
 #include "scr_special.h"
+#include "scr_index.h"
+#include "scr_cache.h"
 #include "update.h"
 #include "message.h"
 
@@ -163,6 +165,8 @@ setCurrentScreen (BaseScreen *screen) {
     currentScreen->onBackground();
     currentScreen = screen;
     currentScreen->onForeground();
+    invalidateScreenIndex();
+    invalidateScreenCache();
 
     scheduleUpdate("new screen selected");
     announceCurrentScreen();
@@ -134,3 +134,32 @@ const ScreenSegmentCharacter *
 getScreenEnd (ScreenSegmentHeader *segment) {
   return getScreenRow(segment, segment->screenHeight, NULL);
 }
+
+int
+testScreenSegmentField (const ScreenSegmentHeader *segment, size_t offset) {
+  return segment->headerSize >= offset;
+}
+
+uint32_t
+setScreenSegmentFlags (ScreenSegmentHeader *segment, uint32_t flags) {
+#ifdef HAVE_SYNC_FETCH_AND_OR
+  return __sync_fetch_and_or(&segment->commonFlags, flags);
+#else /* HAVE_SYNC_FETCH_AND_OR */
+  uint32_t oldFlags = segment->commonFlags;
+  segment->commonFlags = oldFlags | flags;
+  __sync_synchronize();
+  return oldFlags;
+#endif /* HAVE_SYNC_FETCH_AND_OR */
+}
+
+uint32_t
+clearScreenSegmentFlags (ScreenSegmentHeader *segment, uint32_t flags) {
+#ifdef HAVE_SYNC_FETCH_AND_OR
+  return __sync_fetch_and_and(&segment->commonFlags, ~flags);
+#else /* HAVE_SYNC_FETCH_AND_OR */
+  uint32_t oldFlags = segment->commonFlags;
+  segment->commonFlags = oldFlags & ~flags;
+  __sync_synchronize();
+  return oldFlags;
+#endif /* HAVE_SYNC_FETCH_AND_OR */
+}
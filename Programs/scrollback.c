@@ -0,0 +1,564 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "parameters.h"
+#include "program.h"
+#include "memusage.h"
+#include "utf8.h"
+#include "scr.h"
+#include "scrollback.h"
+
+/* A row is kept compactly: its text, without the trailing spaces, as UTF-8
+ * and its attributes as runs (they seldom change along a row).
+ */
+
+typedef struct {
+  uint16_t count;
+  unsigned char attributes;
+} ScrollbackAttributes;
+
+typedef struct {
+  uint16_t width;
+  uint16_t length;
+  uint16_t textSize;
+  uint16_t attributesCount;
+  ScrollbackAttributes attributes[];
+  /* followed by the text */
+} ScrollbackRow;
+
+static inline const char *
+getRowText (const ScrollbackRow *row) {
+  return (const char *)&row->attributes[row->attributesCount];
+}
+
+static inline size_t
+getRowSize (const ScrollbackRow *row) {
+  return sizeof(*row)
+       + ARRAY_SIZE(row->attributes, row->attributesCount)
+       + row->textSize;
+}
+
+/* The rows of a screen are kept in a ring so that a new one can be added,
+ * and the oldest one dropped, without moving the others.
+ */
+
+typedef struct {
+  int screen;
+  unsigned long int lastUsed;
+
+  ScrollbackRow **rows;
+  unsigned int capacity;
+  unsigned int first;
+  unsigned int count;
+} ScrollbackHistory;
+
+static ScrollbackHistory scrollbackHistories[SCROLLBACK_SCREEN_LIMIT];
+static unsigned int scrollbackHistoryCount = 0;
+static unsigned long int scrollbackUseCounter = 0;
+
+typedef struct {
+  int screen;
+  int columns;
+  int rows;
+  int cursor;
+
+  ScreenCharacter *characters;
+  uint64_t *hashes;
+  unsigned char *blank;
+} ScreenImage;
+
+static ScreenImage screenImages[2];
+static ScreenImage *previousImage = &screenImages[0];
+static ScreenImage *currentImage = &screenImages[1];
+
+static size_t scrollbackSize = 0;
+static size_t scrollbackMemoryUsage = 0;
+static unsigned char scrollbackExitRegistered = 0;
+
+static void
+updateScrollbackMemoryUsage (void) {
+  size_t size = scrollbackSize;
+
+  for (unsigned int index=0; index<ARRAY_COUNT(screenImages); index+=1) {
+    const ScreenImage *image = &screenImages[index];
+
+    if (image->characters) {
+      size_t count = image->columns * image->rows;
+      size += ARRAY_SIZE(image->characters, count);
+      size += ARRAY_SIZE(image->hashes, image->rows);
+      size += ARRAY_SIZE(image->blank, image->rows);
+    }
+  }
+
+  updateMemoryUsage(MEMORY_SCREEN_CACHES, &scrollbackMemoryUsage, size);
+}
+
+static void
+exitScrollback (void *data) {
+  discardScrollback();
+}
+
+static void
+registerScrollbackExit (void) {
+  if (!scrollbackExitRegistered) {
+    onProgramExit("scrollback", exitScrollback, NULL);
+    scrollbackExitRegistered = 1;
+  }
+}
+
+static ScrollbackRow *
+newScrollbackRow (const ScreenCharacter *characters, unsigned int width) {
+  unsigned int length = width;
+  while (length && (characters[length-1].text == WC_C(' '))) length -= 1;
+
+  unsigned int attributesCount = 0;
+  for (unsigned int column=0; column<width; column+=1) {
+    if (!column || (characters[column].attributes != characters[column-1].attributes)) {
+      attributesCount += 1;
+    }
+  }
+
+  char text[(length * UTF8_LEN_MAX) + 1];
+  size_t textSize = 0;
+
+  for (unsigned int column=0; column<length; column+=1) {
+    Utf8Buffer utf8;
+    size_t size = convertWcharToUtf8(characters[column].text, utf8);
+
+    memcpy(&text[textSize], utf8, size);
+    textSize += size;
+  }
+
+  ScrollbackRow *row;
+  size_t size = sizeof(*row) + ARRAY_SIZE(row->attributes, attributesCount) + textSize;
+
+  if (!(row = malloc(size))) {
+    logMallocError();
+    return NULL;
+  }
+
+  row->width = width;
+  row->length = length;
+  row->textSize = textSize;
+  row->attributesCount = attributesCount;
+
+  {
+    ScrollbackAttributes *attributes = NULL;
+
+    for (unsigned int column=0; column<width; column+=1) {
+      if (!column || (characters[column].attributes != characters[column-1].attributes)) {
+        attributes = attributes? (attributes + 1): row->attributes;
+        attributes->count = 0;
+        attributes->attributes = characters[column].attributes;
+      }
+
+      attributes->count += 1;
+    }
+  }
+
+  memcpy((char *)getRowText(row), text, textSize);
+  return row;
+}
+
+static void
+getScrollbackCharacters (const ScrollbackRow *row, int left, int width, ScreenCharacter *buffer) {
+  int right = left + width;
+
+  for (int index=0; index<width; index+=1) {
+    ScreenCharacter *character = &buffer[index];
+    character->text = WC_C(' ');
+    character->attributes = SCR_COLOUR_DEFAULT;
+  }
+
+  {
+    const ScrollbackAttributes *attributes = row->attributes;
+    const ScrollbackAttributes *end = attributes + row->attributesCount;
+    int column = 0;
+
+    while ((attributes < end) && (column < right)) {
+      int next = column + attributes->count;
+      int from = MAX(column, left);
+      int to = MIN(next, right);
+
+      while (from < to) buffer[from++ - left].attributes = attributes->attributes;
+      column = next;
+      attributes += 1;
+    }
+  }
+
+  {
+    const char *byte = getRowText(row);
+    size_t count = row->textSize;
+    int to = MIN(row->length, right);
+
+    for (int column=0; column<to; column+=1) {
+      wint_t wc = convertUtf8ToWchar(&byte, &count);
+      if (wc == WEOF) break;
+      if (column >= left) buffer[column - left].text = wc;
+    }
+  }
+}
+
+static void
+removeOldestRow (ScrollbackHistory *history) {
+  ScrollbackRow *row = history->rows[history->first];
+
+  scrollbackSize -= getRowSize(row);
+  free(row);
+
+  history->first = (history->first + 1) % history->capacity;
+  history->count -= 1;
+}
+
+static void
+clearHistory (ScrollbackHistory *history) {
+  while (history->count) removeOldestRow(history);
+
+  if (history->rows) {
+    scrollbackSize -= ARRAY_SIZE(history->rows, history->capacity);
+    free(history->rows);
+    history->rows = NULL;
+  }
+
+  history->capacity = 0;
+  history->first = 0;
+}
+
+static ScrollbackHistory *
+getHistory (int screen, int create) {
+  ScrollbackHistory *oldest = NULL;
+
+  for (unsigned int index=0; index<scrollbackHistoryCount; index+=1) {
+    ScrollbackHistory *history = &scrollbackHistories[index];
+
+    if (history->screen == screen) {
+      history->lastUsed = ++scrollbackUseCounter;
+      return history;
+    }
+
+    if (!oldest || (history->lastUsed < oldest->lastUsed)) oldest = history;
+  }
+
+  if (!create) return NULL;
+  ScrollbackHistory *history;
+
+  if (scrollbackHistoryCount < ARRAY_COUNT(scrollbackHistories)) {
+    history = &scrollbackHistories[scrollbackHistoryCount++];
+    memset(history, 0, sizeof(*history));
+  } else {
+    history = oldest;
+    clearHistory(history);
+  }
+
+  history->screen = screen;
+  history->lastUsed = ++scrollbackUseCounter;
+  return history;
+}
+
+static int
+makeRoom (ScrollbackHistory *history) {
+  if (history->count < history->capacity) return 1;
+
+  if (history->capacity < SCROLLBACK_MAXIMUM_ROWS) {
+    unsigned int capacity = history->capacity? (history->capacity << 1): 0X40;
+    if (capacity > SCROLLBACK_MAXIMUM_ROWS) capacity = SCROLLBACK_MAXIMUM_ROWS;
+
+    ScrollbackRow **rows = malloc(ARRAY_SIZE(rows, capacity));
+
+    if (rows) {
+      for (unsigned int index=0; index<history->count; index+=1) {
+        rows[index] = history->rows[(history->first + index) % history->capacity];
+      }
+
+      if (history->rows) {
+        scrollbackSize -= ARRAY_SIZE(history->rows, history->capacity);
+        free(history->rows);
+      }
+
+      history->rows = rows;
+      history->capacity = capacity;
+      history->first = 0;
+      scrollbackSize += ARRAY_SIZE(history->rows, history->capacity);
+      return 1;
+    }
+
+    logMallocError();
+    if (!history->count) return 0;
+  }
+
+  removeOldestRow(history);
+  return 1;
+}
+
+static ScrollbackHistory *
+getLeastRecentlyUsedHistory (const ScrollbackHistory *current) {
+  ScrollbackHistory *oldest = NULL;
+
+  for (unsigned int index=0; index<scrollbackHistoryCount; index+=1) {
+    ScrollbackHistory *history = &scrollbackHistories[index];
+
+    if (history == current) continue;
+    if (!history->rows) continue;
+    if (!oldest || (history->lastUsed < oldest->lastUsed)) oldest = history;
+  }
+
+  return oldest;
+}
+
+/* The size limit is shared by all of the screens, so the least recently used
+ * of the others give up their rows before the current one does.
+ */
+static void
+trimScrollback (ScrollbackHistory *current) {
+  while (scrollbackSize > SCROLLBACK_MAXIMUM_SIZE) {
+    ScrollbackHistory *history = getLeastRecentlyUsedHistory(current);
+
+    if (history) {
+      if (history->count) removeOldestRow(history);
+      if (!history->count) clearHistory(history);
+    } else if (current->count) {
+      removeOldestRow(current);
+    } else {
+      break;
+    }
+  }
+}
+
+static void
+appendRows (int screen, const ScreenCharacter *characters, unsigned int width, unsigned int count) {
+  ScrollbackHistory *history = getHistory(screen, 1);
+
+  while (count > 0) {
+    ScrollbackRow *row = newScrollbackRow(characters, width);
+    if (!row) break;
+
+    if (!makeRoom(history)) {
+      free(row);
+      break;
+    }
+
+    history->rows[(history->first + history->count++) % history->capacity] = row;
+    scrollbackSize += getRowSize(row);
+
+    characters += width;
+    count -= 1;
+  }
+
+  trimScrollback(history);
+  registerScrollbackExit();
+}
+
+static uint64_t
+hashRow (const ScreenCharacter *characters, unsigned int count, unsigned char *blank) {
+  uint64_t hash = UINT64_C(0XCBF29CE484222325);
+  *blank = 1;
+
+  while (count > 0) {
+    wchar_t text = characters++->text;
+    if (text != WC_C(' ')) *blank = 0;
+
+    hash ^= (uint32_t)text;
+    hash *= UINT64_C(0X100000001B3);
+    count -= 1;
+  }
+
+  return hash;
+}
+
+static void
+deallocateImage (ScreenImage *image) {
+  if (image->characters) {
+    free(image->characters);
+    image->characters = NULL;
+  }
+
+  if (image->hashes) {
+    free(image->hashes);
+    image->hashes = NULL;
+  }
+
+  if (image->blank) {
+    free(image->blank);
+    image->blank = NULL;
+  }
+
+  image->columns = 0;
+  image->rows = 0;
+}
+
+static int
+readImage (ScreenImage *image, const ScreenDescription *description) {
+  int columns = description->cols;
+  int rows = description->rows;
+
+  if ((columns != image->columns) || (rows != image->rows) || !image->characters) {
+    deallocateImage(image);
+
+    size_t count = columns * rows;
+    if (!count) return 0;
+
+    if (!(image->characters = malloc(ARRAY_SIZE(image->characters, count))) ||
+        !(image->hashes = malloc(ARRAY_SIZE(image->hashes, rows))) ||
+        !(image->blank = malloc(ARRAY_SIZE(image->blank, rows)))) {
+      logMallocError();
+      deallocateImage(image);
+      return 0;
+    }
+
+    image->columns = columns;
+    image->rows = rows;
+    updateScrollbackMemoryUsage();
+    registerScrollbackExit();
+  }
+
+  image->screen = description->number;
+  image->cursor = description->posy;
+  if (!readScreen(0, 0, columns, rows, image->characters)) return 0;
+
+  for (int row=0; row<rows; row+=1) {
+    image->hashes[row] = hashRow(
+      &image->characters[row * columns], columns, &image->blank[row]
+    );
+  }
+
+  return 1;
+}
+
+static int
+isSameImageRow (const ScreenImage *image1, int row1, const ScreenImage *image2, int row2) {
+  if (image1->hashes[row1] != image2->hashes[row2]) return 0;
+
+  const ScreenCharacter *character1 = &image1->characters[row1 * image1->columns];
+  const ScreenCharacter *character2 = &image2->characters[row2 * image2->columns];
+  const ScreenCharacter *end = character1 + image1->columns;
+
+  while (character1 < end) {
+    if (character1++->text != character2++->text) return 0;
+  }
+
+  return 1;
+}
+
+static unsigned int
+getScrolledRowCount (const ScreenImage *old, const ScreenImage *new) {
+  /* The row the cursor is on, and any below it, may well have changed (a
+   * command being typed, for example) so only the rows above it are compared.
+   */
+  int limit = old->rows;
+  if ((old->cursor >= 0) && (old->cursor < limit)) limit = old->cursor;
+
+  {
+    int row = 0;
+
+    while (row < limit) {
+      if (!isSameImageRow(old, row, new, row)) break;
+      row += 1;
+    }
+
+    if (row == limit) return 0;
+  }
+
+  for (int scrolled=1; (limit-scrolled)>=SCROLLBACK_MINIMUM_OVERLAP; scrolled+=1) {
+    int blank = 1;
+    int row = scrolled;
+
+    while (row < limit) {
+      if (!isSameImageRow(old, row, new, row-scrolled)) break;
+      if (!old->blank[row]) blank = 0;
+      row += 1;
+    }
+
+    /* Rows of spaces match one another too readily to be trusted alone. */
+    if ((row == limit) && !blank) return scrolled;
+  }
+
+  return 0;
+}
+
+void
+captureScrollback (const ScreenDescription *description) {
+  if (!readImage(currentImage, description)) return;
+
+  {
+    const ScreenImage *old = previousImage;
+    const ScreenImage *new = currentImage;
+
+    if (old->characters && (old->screen == new->screen) &&
+        (old->columns == new->columns) && (old->rows == new->rows)) {
+      unsigned int count = getScrolledRowCount(old, new);
+
+      if (count) {
+        logMessage(LOG_CATEGORY(UPDATE_EVENTS),
+                   "scrollback: screen=%d rows=%u", new->screen, count);
+
+        appendRows(old->screen, old->characters, old->columns, count);
+        updateScrollbackMemoryUsage();
+      }
+    }
+  }
+
+  {
+    ScreenImage *image = previousImage;
+    previousImage = currentImage;
+    currentImage = image;
+  }
+}
+
+void
+discardScrollback (void) {
+  for (unsigned int index=0; index<scrollbackHistoryCount; index+=1) {
+    clearHistory(&scrollbackHistories[index]);
+  }
+
+  scrollbackHistoryCount = 0;
+
+  for (unsigned int index=0; index<ARRAY_COUNT(screenImages); index+=1) {
+    deallocateImage(&screenImages[index]);
+  }
+
+  updateScrollbackMemoryUsage();
+}
+
+unsigned int
+getScrollbackRowCount (int screen) {
+  const ScrollbackHistory *history = getHistory(screen, 0);
+  if (!history) return 0;
+  return history->count;
+}
+
+int
+readScrollbackRow (
+  int screen, unsigned int row,
+  int left, int width, ScreenCharacter *buffer
+) {
+  const ScrollbackHistory *history = getHistory(screen, 0);
+  if (!history) return 0;
+  if (row >= history->count) return 0;
+
+  getScrollbackCharacters(
+    history->rows[(history->first + row) % history->capacity],
+    left, width, buffer
+  );
+
+  return 1;
+}
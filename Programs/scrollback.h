@@ -0,0 +1,45 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_SCROLLBACK
+#define BRLTTY_INCLUDED_SCROLLBACK
+
+#include "scr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Rows which scroll off the top of the main screen are kept (per screen
+ * number) so that they can be reviewed when the screen is frozen.
+ */
+extern void captureScrollback (const ScreenDescription *description);
+extern void discardScrollback (void);
+
+extern unsigned int getScrollbackRowCount (int screen);
+
+extern int readScrollbackRow (
+  int screen, unsigned int row,
+  int left, int width, ScreenCharacter *buffer
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_SCROLLBACK */
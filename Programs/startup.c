@@ -0,0 +1,274 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "log.h"
+#include "strfmt.h"
+#include "startup.h"
+#include "thread.h"
+#include "timing.h"
+#include "pid.h"
+
+/* Phases are recorded from the very start of the program because whether or
+ * not they're wanted isn't known until the options have been processed. Once
+ * the report has been declined (or written) recording stops, so the cost of
+ * an unwanted phase is a single test.
+ */
+
+typedef enum {
+  SRS_PENDING,
+  SRS_ENABLED,
+  SRS_DISABLED
+} StartupReportState;
+
+static StartupReportState startupReportState = SRS_PENDING;
+static char *startupTraceFile = NULL;
+
+#define STARTUP_PHASE_LIMIT 0X80
+#define STARTUP_PHASE_DEPTH 0X10
+#define STARTUP_THREAD_NAME_SIZE 0X20
+
+typedef struct {
+  const char *name;
+  unsigned int thread;
+  char threadName[STARTUP_THREAD_NAME_SIZE];
+  unsigned char depth;
+  unsigned char finished;
+  TimeValue begin;
+  TimeValue end;
+} StartupPhase;
+
+static CriticalSectionLock startupPhaseLock = CRITICAL_SECTION_LOCK_INITIALIZER;
+static StartupPhase startupPhases[STARTUP_PHASE_LIMIT];
+static unsigned int startupPhaseCount = 0;
+
+#ifdef THREAD_LOCAL
+#define STARTUP_PHASE_STACK_STORAGE static THREAD_LOCAL
+#else /* THREAD_LOCAL */
+#define STARTUP_PHASE_STACK_STORAGE static
+#endif /* THREAD_LOCAL */
+
+STARTUP_PHASE_STACK_STORAGE unsigned int startupPhaseStack[STARTUP_PHASE_DEPTH];
+STARTUP_PHASE_STACK_STORAGE unsigned int startupPhaseDepth = 0;
+STARTUP_PHASE_STACK_STORAGE unsigned int startupThreadNumber = 0;
+static unsigned int startupThreadCount = 0;
+
+void
+beginStartupPhase (const char *name) {
+  unsigned int index = STARTUP_PHASE_LIMIT;
+
+  if (startupReportState == SRS_DISABLED) {
+    if (!startupPhaseDepth) return;
+  } else if (startupPhaseDepth < STARTUP_PHASE_DEPTH) {
+    enterCriticalSection(&startupPhaseLock);
+      if (startupPhaseCount < STARTUP_PHASE_LIMIT) {
+        StartupPhase *phase = &startupPhases[index = startupPhaseCount++];
+        memset(phase, 0, sizeof(*phase));
+
+        phase->name = name;
+        phase->depth = startupPhaseDepth;
+
+        if (!startupThreadNumber) startupThreadNumber = ++startupThreadCount;
+        phase->thread = startupThreadNumber;
+        formatThreadName(phase->threadName, sizeof(phase->threadName));
+        getMonotonicTime(&phase->begin);
+      }
+    leaveCriticalSection(&startupPhaseLock);
+  }
+
+  if (startupPhaseDepth < STARTUP_PHASE_DEPTH) startupPhaseStack[startupPhaseDepth] = index;
+  startupPhaseDepth += 1;
+}
+
+void
+endStartupPhase (void) {
+  if (!startupPhaseDepth) return;
+  if (--startupPhaseDepth >= STARTUP_PHASE_DEPTH) return;
+
+  unsigned int index = startupPhaseStack[startupPhaseDepth];
+  if (index == STARTUP_PHASE_LIMIT) return;
+
+  enterCriticalSection(&startupPhaseLock);
+    StartupPhase *phase = &startupPhases[index];
+    getMonotonicTime(&phase->end);
+    phase->finished = 1;
+  leaveCriticalSection(&startupPhaseLock);
+}
+
+static long int
+getStartupMicroseconds (const TimeValue *from, const TimeValue *to) {
+  return ((long int)(to->seconds - from->seconds) * 1000000)
+       + (((long int)to->nanoseconds - (long int)from->nanoseconds) / 1000);
+}
+
+static void
+logStartupPhases (const TimeValue *now) {
+  const StartupPhase *first = &startupPhases[0];
+  logMessage(LOG_NOTICE, "startup phases:");
+
+  for (unsigned int index=0; index<startupPhaseCount; index+=1) {
+    const StartupPhase *phase = &startupPhases[index];
+    const TimeValue *end = phase->finished? &phase->end: now;
+    long int start = getStartupMicroseconds(&first->begin, &phase->begin);
+    long int duration = getStartupMicroseconds(&phase->begin, end);
+
+    char line[0X100];
+    STR_BEGIN(line, sizeof(line));
+
+    STR_PRINTF(
+      "%*s%s: %ld.%03ldms (at %ld.%03ldms)",
+      (phase->depth + 1) * 2, "", phase->name,
+      duration / 1000, duration % 1000,
+      start / 1000, start % 1000
+    );
+
+    if (!phase->finished) STR_PRINTF(" unfinished");
+    if (phase->thread != first->thread) STR_PRINTF(" [%u:%s]", phase->thread, phase->threadName);
+
+    STR_END;
+    logMessage(LOG_NOTICE, "%s", line);
+  }
+
+  {
+    long int total = getStartupMicroseconds(&first->begin, now);
+    logMessage(LOG_NOTICE, "startup time: %ld.%03ldms", total / 1000, total % 1000);
+  }
+
+  if (startupPhaseCount == STARTUP_PHASE_LIMIT) {
+    logMessage(LOG_WARNING, "startup phase limit reached: %u", STARTUP_PHASE_LIMIT);
+  }
+}
+
+static void
+writeJsonString (FILE *stream, const char *string) {
+  fputc('"', stream);
+
+  while (*string) {
+    char character = *string++;
+
+    if ((character == '"') || (character == '\\')) {
+      fputc('\\', stream);
+    } else if ((unsigned char)character < 0X20) {
+      fprintf(stream, "\\u%04X", character);
+      continue;
+    }
+
+    fputc(character, stream);
+  }
+
+  fputc('"', stream);
+}
+
+static void
+writeStartupTrace (const char *path, const TimeValue *now) {
+  FILE *stream = fopen(path, "w");
+
+  if (!stream) {
+    logMessage(LOG_WARNING, "cannot open startup trace file: %s: %s", path, strerror(errno));
+    return;
+  }
+
+  const StartupPhase *first = &startupPhases[0];
+  ProcessIdentifier pid = getProcessIdentifier();
+  unsigned int threadsNamed = 0;
+  const char *delimiter = "\n";
+  fprintf(stream, "{\"traceEvents\":[");
+
+  for (unsigned int index=0; index<startupPhaseCount; index+=1) {
+    const StartupPhase *phase = &startupPhases[index];
+    unsigned int thread = phase->thread;
+
+    if (thread > threadsNamed) {
+      threadsNamed = thread;
+
+      fprintf(stream,
+        "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%" PRIpid ",\"tid\":%u,\"args\":{\"name\":",
+        delimiter, pid, thread
+      );
+
+      writeJsonString(stream, phase->threadName);
+      fprintf(stream, "}}");
+      delimiter = ",\n";
+    }
+
+    {
+      const TimeValue *end = phase->finished? &phase->end: now;
+
+      fprintf(stream, "%s{\"ph\":\"X\",\"name\":", delimiter);
+      writeJsonString(stream, phase->name);
+
+      fprintf(stream,
+        ",\"pid\":%" PRIpid ",\"tid\":%u,\"ts\":%ld,\"dur\":%ld}",
+        pid, thread,
+        getStartupMicroseconds(&first->begin, &phase->begin),
+        getStartupMicroseconds(&phase->begin, end)
+      );
+
+      delimiter = ",\n";
+    }
+  }
+
+  fprintf(stream, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (fclose(stream) == EOF) {
+    logMessage(LOG_WARNING, "startup trace file write error: %s: %s", path, strerror(errno));
+  } else {
+    logMessage(LOG_INFO, "startup trace written: %s", path);
+  }
+}
+
+void
+setStartupReport (int enabled, const char *traceFile) {
+  if (startupReportState != SRS_PENDING) return;
+
+  if (traceFile && *traceFile) {
+    if (!(startupTraceFile = strdup(traceFile))) {
+      logMallocError();
+    }
+
+    enabled = 1;
+  }
+
+  startupReportState = enabled? SRS_ENABLED: SRS_DISABLED;
+}
+
+void
+finishStartupReport (void) {
+  if (startupReportState != SRS_ENABLED) return;
+  startupReportState = SRS_DISABLED;
+
+  enterCriticalSection(&startupPhaseLock);
+    if (startupPhaseCount) {
+      TimeValue now;
+      getMonotonicTime(&now);
+
+      logStartupPhases(&now);
+      if (startupTraceFile) writeStartupTrace(startupTraceFile, &now);
+    }
+  leaveCriticalSection(&startupPhaseLock);
+
+  if (startupTraceFile) {
+    free(startupTraceFile);
+    startupTraceFile = NULL;
+  }
+}
@@ -222,23 +222,23 @@ unlockMutex (pthread_mutex_t *mutex) {
 #if defined(HAVE_PTHREAD_GETNAME_NP) && defined(__GLIBC__)
 #define HAVE_THREAD_NAMES
 
-size_t
-formatThreadName (char *buffer, size_t size) {
+static size_t
+formatSystemThreadName (char *buffer, size_t size) {
   int error = pthread_getname_np(pthread_self(), buffer, size);
 
   return error? 0: strlen(buffer);
 }
 
-void
-setThreadName (const char *name) {
+static void
+setSystemThreadName (const char *name) {
   pthread_setname_np(pthread_self(), name);
 }
 
 #elif defined(HAVE_PTHREAD_GETNAME_NP) && defined(__APPLE__)
 #define HAVE_THREAD_NAMES
 
-size_t
-formatThreadName (char *buffer, size_t size) {
+static size_t
+formatSystemThreadName (char *buffer, size_t size) {
   {
     int error = pthread_getname_np(pthread_self(), buffer, size);
 
@@ -260,15 +260,60 @@ formatThreadName (char *buffer, size_t size) {
   return 0;
 }
 
-void
-setThreadName (const char *name) {
+static void
+setSystemThreadName (const char *name) {
   pthread_setname_np(name);
 }
 
 #endif /* thread names */
 #endif /* GOT_PTHREADS */
 
-#ifndef HAVE_THREAD_NAMES
+#ifdef HAVE_THREAD_NAMES
+#ifdef THREAD_LOCAL
+/* Each thread remembers its own name so that the system needn't be asked
+ * for it every time a log record is written.
+ */
+static THREAD_LOCAL char threadNameCache[0X40];
+static THREAD_LOCAL unsigned char threadNameCached = 0;
+
+size_t
+formatThreadName (char *buffer, size_t size) {
+  if (!threadNameCached) {
+    size_t length = formatSystemThreadName(threadNameCache, sizeof(threadNameCache));
+
+    if (length >= sizeof(threadNameCache)) length = sizeof(threadNameCache) - 1;
+    threadNameCache[length] = 0;
+    threadNameCached = 1;
+  }
+
+  if (!size) return 0;
+  size_t length = strlen(threadNameCache);
+  if (length >= size) length = size - 1;
+
+  memcpy(buffer, threadNameCache, length);
+  buffer[length] = 0;
+  return length;
+}
+
+void
+setThreadName (const char *name) {
+  setSystemThreadName(name);
+  threadNameCached = 0;
+}
+
+#else /* THREAD_LOCAL */
+size_t
+formatThreadName (char *buffer, size_t size) {
+  return formatSystemThreadName(buffer, size);
+}
+
+void
+setThreadName (const char *name) {
+  setSystemThreadName(name);
+}
+#endif /* THREAD_LOCAL */
+
+#else /* HAVE_THREAD_NAMES */
 size_t
 formatThreadName (char *buffer, size_t size) {
   return 0;
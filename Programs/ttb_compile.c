@@ -24,6 +24,7 @@
 #include "file.h"
 #include "datafile.h"
 #include "dataarea.h"
+#include "memusage.h"
 #include "charset.h"
 #include "ttb.h"
 #include "ttb_internal.h"
@@ -348,6 +349,7 @@ makeTextTable (TextTableData *ttd) {
   TextTable *table = malloc(sizeof(*table));
 
   if (table) {
+    shrinkDataArea(ttd->area);
     memset(table, 0, sizeof(*table));
 
     table->header.fields = getTextTableHeader(ttd);
@@ -361,6 +363,7 @@ makeTextTable (TextTableData *ttd) {
       if (!*cell) *cell = getUnicodeCell(ttd, WC_C('?'));
     }
 
+    addMemoryUsage(MEMORY_TABLES, table->size);
     resetDataArea(ttd->area);
   }
 
@@ -370,6 +373,7 @@ makeTextTable (TextTableData *ttd) {
 void
 destroyTextTable (TextTable *table) {
   if (table->size) {
+    subtractMemoryUsage(MEMORY_TABLES, table->size);
     free(table->header.fields);
     free(table);
   }
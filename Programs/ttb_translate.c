@@ -261,8 +261,8 @@ convertInputToCharacter (unsigned char dots) {
   }
 }
 
-int
-replaceTextTable (const char *directory, const char *name) {
+TextTable *
+compileNamedTextTable (const char *directory, const char *name) {
   TextTable *newTable = NULL;
 
   if (*name) {
@@ -281,14 +281,26 @@ replaceTextTable (const char *directory, const char *name) {
     newTable = &internalTextTable;
   }
 
-  if (newTable) {
-    TextTable *oldTable = textTable;
+  return newTable;
+}
+
+void
+installTextTable (TextTable *newTable) {
+  TextTable *oldTable = textTable;
 
-    lockTextTable();
-      textTable = newTable;
-    unlockTextTable();
+  lockTextTable();
+    textTable = newTable;
+  unlockTextTable();
 
-    destroyTextTable(oldTable);
+  destroyTextTable(oldTable);
+}
+
+int
+replaceTextTable (const char *directory, const char *name) {
+  TextTable *newTable = compileNamedTextTable(directory, name);
+
+  if (newTable) {
+    installTextTable(newTable);
     return 1;
   }
 
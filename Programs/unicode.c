@@ -71,6 +71,15 @@ nextBaseCharacter (const UChar **current, const UChar *end) {
 #include <iconv.h>
 #endif /* HAVE_ICONV_H */
 
+/* The conversion handles are opened on first use and then kept. Each thread
+ * has its own so that characters can be converted concurrently.
+ */
+#ifdef THREAD_LOCAL
+#define UNICODE_HANDLE_STORAGE static THREAD_LOCAL
+#else /* THREAD_LOCAL */
+#define UNICODE_HANDLE_STORAGE static
+#endif /* THREAD_LOCAL */
+
 int
 getCharacterName (wchar_t character, char *buffer, size_t size) {
 #ifdef HAVE_ICU
@@ -232,7 +241,7 @@ composeCharacters (
     UErrorCode error = U_ZERO_ERROR;
 
 #ifdef HAVE_UNICODE_UNORM2_H
-    static const UNormalizer2 *normalizer = NULL;
+    UNICODE_HANDLE_STORAGE const UNormalizer2 *normalizer = NULL;
 
     if (!normalizer) {
       normalizer = unorm2_getNFCInstance(&error);
@@ -297,7 +306,7 @@ decomposeCharacter (
       UErrorCode error = U_ZERO_ERROR;
 
 #ifdef HAVE_UNICODE_UNORM2_H
-      static const UNormalizer2 *normalizer = NULL;
+      UNICODE_HANDLE_STORAGE const UNormalizer2 *normalizer = NULL;
 
       if (!normalizer) {
         normalizer = unorm2_getNFDInstance(&error);
@@ -346,7 +355,7 @@ getBaseCharacter (wchar_t character) {
 wchar_t
 getTransliteratedCharacter (wchar_t character) {
 #ifdef HAVE_ICONV_H
-  static iconv_t handle = NULL;
+  UNICODE_HANDLE_STORAGE iconv_t handle = NULL;
   if (!handle) handle = iconv_open("ASCII//TRANSLIT", "WCHAR_T");
 
   if (handle != (iconv_t)-1) {
@@ -39,6 +39,7 @@
 #include "scr.h"
 #include "scr_special.h"
 #include "scr_utils.h"
+#include "scrollback.h"
 #include "prefs.h"
 #include "status.h"
 #include "blink.h"
@@ -54,24 +55,64 @@ int contractedTrack = 0;
 int *contractedOffsets = NULL;
 static size_t contractedOffsetsSize = 0;
 
+/* When the display has more than one row, each of the others shows its own
+ * screen row, contracted from the same column as the first one - unless the
+ * wrap contracted line preference is set, in which case the first screen row
+ * is contracted across all of them.
+ */
+typedef struct {
+  int *offsets;
+  size_t size;
+  int length;
+} ContractedRow;
+
+static ContractedRow *contractedRows = NULL;
+static unsigned int contractedRowCount = 0;
+static unsigned int contractedRowsShown = 0;
+
 static int
-ensureContractedOffsetsSize (size_t size) {
-  if (++size > contractedOffsetsSize) {
+ensureOffsetsSize (int **offsets, size_t *offsetsSize, size_t size) {
+  if (++size > *offsetsSize) {
     size_t newSize = 1;
     while (newSize < size) newSize <<= 1;
 
-    int *newOffsets = realloc(
-      contractedOffsets,
-      ARRAY_SIZE(contractedOffsets, newSize)
-    );
+    int *newOffsets = realloc(*offsets, ARRAY_SIZE(*offsets, newSize));
 
     if (!newOffsets) {
       logMallocError();
       return 0;
     }
 
-    contractedOffsets = newOffsets;
-    contractedOffsetsSize = newSize;
+    *offsets = newOffsets;
+    *offsetsSize = newSize;
+  }
+
+  return 1;
+}
+
+static int
+ensureContractedOffsetsSize (size_t size) {
+  return ensureOffsetsSize(&contractedOffsets, &contractedOffsetsSize, size);
+}
+
+static int
+ensureContractedRowCount (unsigned int count) {
+  if (count > contractedRowCount) {
+    ContractedRow *newRows = realloc(contractedRows, ARRAY_SIZE(contractedRows, count));
+
+    if (!newRows) {
+      logMallocError();
+      return 0;
+    }
+
+    while (contractedRowCount < count) {
+      ContractedRow *row = &newRows[contractedRowCount++];
+      row->offsets = NULL;
+      row->size = 0;
+      row->length = 0;
+    }
+
+    contractedRows = newRows;
   }
 
   return 1;
@@ -199,7 +240,24 @@ getScreenCursorPosition (int x, int y) {
   if (isContracted) {
     int uncontractedOffset = getUncontractedCursorOffset(x, y);
 
-    if (uncontractedOffset != BRL_NO_CURSOR) {
+    if ((y > ses->winy) && ((y - ses->winy) < contractedRowsShown)) {
+      unsigned int row = y - ses->winy;
+      const ContractedRow *contractedRow = &contractedRows[row];
+      uncontractedOffset = getUncontractedRowOffset(x, y, y);
+
+      if ((uncontractedOffset != BRL_NO_CURSOR) && (uncontractedOffset < contractedRow->length)) {
+        while (uncontractedOffset >= 0) {
+          int contractedOffset = contractedRow->offsets[uncontractedOffset];
+
+          if (contractedOffset != CTB_NO_OFFSET) {
+            position = (row * brl.textColumns) + textStart + contractedOffset;
+            break;
+          }
+
+          uncontractedOffset -= 1;
+        }
+      }
+    } else if (uncontractedOffset != BRL_NO_CURSOR) {
       if (uncontractedOffset < contractedLength) {
         const unsigned int windowLength = brl.textColumns * brl.textRows;
 
@@ -259,6 +317,89 @@ overlayAttributesUnderline (unsigned char *cell, unsigned char attributes) {
   }
 }
 
+static void
+applyContractedAttributes (
+  const ScreenCharacter *characters, int length, const int *offsets,
+  unsigned char *cells, int count
+) {
+  int inputOffset;
+  int outputOffset = 0;
+  unsigned char attributes = 0;
+  unsigned char attributesBuffer[count];
+
+  for (inputOffset=0; inputOffset<length; ++inputOffset) {
+    int offset = offsets[inputOffset];
+
+    if (offset != CTB_NO_OFFSET) {
+      while (outputOffset < offset) attributesBuffer[outputOffset++] = attributes;
+      attributes = 0;
+    }
+
+    attributes |= characters[inputOffset].attributes;
+  }
+
+  while (outputOffset < count) attributesBuffer[outputOffset++] = attributes;
+
+  if (ses->displayMode) {
+    for (outputOffset=0; outputOffset<count; ++outputOffset) {
+      cells[outputOffset] = convertAttributesToDots(attributesTable, attributesBuffer[outputOffset]);
+    }
+  } else {
+    unsigned int i;
+
+    for (i=0; i<count; i+=1) {
+      overlayAttributesUnderline(&cells[i], attributesBuffer[i]);
+    }
+  }
+}
+
+static void
+renderContractedRow (unsigned int row, wchar_t *textBuffer) {
+  ContractedRow *contractedRow = &contractedRows[row];
+  contractedRow->length = 0;
+
+  int screenRow = ses->winy + row;
+  if (screenRow >= scr.rows) return;
+
+  int inputLength = scr.cols - ses->winx;
+  if (inputLength < 1) return;
+  if (!ensureOffsetsSize(&contractedRow->offsets, &contractedRow->size, inputLength)) return;
+
+  ScreenCharacter inputCharacters[inputLength];
+  readScreen(ses->winx, screenRow, inputLength, 1, inputCharacters);
+
+  wchar_t inputText[inputLength];
+  for (int i=0; i<inputLength; i+=1) {
+    inputText[i] = inputCharacters[i].text;
+  }
+
+  int cursor = getContractedRowCursor(screenRow);
+  int outputLength = textCount;
+  unsigned char outputCells[outputLength];
+
+  contractText(
+    contractionTable,
+    inputText, &inputLength,
+    outputCells, &outputLength,
+    contractedRow->offsets, cursor
+  );
+
+  contractedRow->length = inputLength;
+
+  if (ses->displayMode || prefs.showAttributes) {
+    applyContractedAttributes(inputCharacters, inputLength, contractedRow->offsets,
+                              outputCells, outputLength);
+  }
+
+  {
+    unsigned int offset = row * brl.textColumns;
+
+    fillDotsRegion(&textBuffer[offset], &brl.buffer[offset],
+                   textStart, textCount, brl.textColumns, 1,
+                   outputCells, outputLength);
+  }
+}
+
 static int
 writeStatusCells (void) {
   if (braille->writeStatus) {
@@ -968,6 +1109,7 @@ doUpdate (void) {
   }
 
   checkScreenScroll(trackScreenScroll);
+  if (isMainScreen() && !scr.unreadable) captureScrollback(&scr);
 
 #ifdef ENABLE_SPEECH_SUPPORT
   if (spk.canAutospeak) {
@@ -1021,6 +1163,10 @@ doUpdate (void) {
       wmemset(textBuffer, WC_C(' '), windowLength);
 
       if (isContracting()) {
+        const int wrapLine = prefs.wrapContractedLine;
+        const unsigned int outputLimit = wrapLine? textLength: textCount;
+        contractedRowsShown = 0;
+
         while (1) {
           int inputLength = scr.cols - ses->winx;
           ensureContractedOffsetsSize(inputLength);
@@ -1033,7 +1179,7 @@ doUpdate (void) {
             inputText[i] = inputCharacters[i].text;
           }
 
-          int outputLength = textLength;
+          int outputLength = outputLimit;
           unsigned char outputCells[outputLength];
 
           contractText(
@@ -1047,7 +1193,7 @@ doUpdate (void) {
             int inputEnd = inputLength;
 
             if (contractedTrack) {
-              if (outputLength == textLength) {
+              if (outputLength == outputLimit) {
                 int inputIndex = inputEnd;
 
                 while (inputIndex) {
@@ -1091,35 +1237,8 @@ doUpdate (void) {
           isContracted = 1;
 
           if (ses->displayMode || prefs.showAttributes) {
-            int inputOffset;
-            int outputOffset = 0;
-            unsigned char attributes = 0;
-            unsigned char attributesBuffer[outputLength];
-
-            for (inputOffset=0; inputOffset<contractedLength; ++inputOffset) {
-              int offset = contractedOffsets[inputOffset];
-
-              if (offset != CTB_NO_OFFSET) {
-                while (outputOffset < offset) attributesBuffer[outputOffset++] = attributes;
-                attributes = 0;
-              }
-
-              attributes |= inputCharacters[inputOffset].attributes;
-            }
-
-            while (outputOffset < outputLength) attributesBuffer[outputOffset++] = attributes;
-
-            if (ses->displayMode) {
-              for (outputOffset=0; outputOffset<outputLength; ++outputOffset) {
-                outputCells[outputOffset] = convertAttributesToDots(attributesTable, attributesBuffer[outputOffset]);
-              }
-            } else {
-              unsigned int i;
-
-              for (i=0; i<outputLength; i+=1) {
-                overlayAttributesUnderline(&outputCells[i], attributesBuffer[i]);
-              }
-            }
+            applyContractedAttributes(inputCharacters, contractedLength, contractedOffsets,
+                                      outputCells, outputLength);
           }
 
           fillDotsRegion(textBuffer, brl.buffer,
@@ -1127,6 +1246,16 @@ doUpdate (void) {
                          outputCells, outputLength);
           break;
         }
+
+        if (isContracted && !wrapLine && (brl.textRows > 1)) {
+          if (ensureContractedRowCount(brl.textRows)) {
+            for (unsigned int row=1; row<brl.textRows; row+=1) {
+              renderContractedRow(row, textBuffer);
+            }
+
+            contractedRowsShown = brl.textRows;
+          }
+        }
       }
 
       if (!isContracted) {
@@ -154,6 +154,18 @@ convertUtf8ToWchar (const char **utf8, size_t *utfs) {
 void
 convertUtf8ToWchars (const char **utf8, wchar_t **characters, size_t count) {
   while (**utf8 && (count > 1)) {
+    {
+      unsigned char byte = **utf8;
+
+      if (!(byte & 0X80)) {
+        /* plain ASCII (by far the most common case) needs no decoding */
+        *(*characters)++ = byte;
+        *utf8 += 1;
+        count -= 1;
+        continue;
+      }
+    }
+
     size_t utfs = UTF8_LEN_MAX;
     wint_t character = convertUtf8ToWchar(utf8, &utfs);
 
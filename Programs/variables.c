@@ -84,9 +84,27 @@ struct VariableNestingLevelStruct {
   unsigned int references;
 };
 
+static inline void
+incrementReferences (VariableNestingLevel *vnl) {
+#ifdef HAVE_SYNC_ADD_AND_FETCH
+  __sync_add_and_fetch(&vnl->references, 1);
+#else /* HAVE_SYNC_ADD_AND_FETCH */
+  vnl->references += 1;
+#endif /* HAVE_SYNC_ADD_AND_FETCH */
+}
+
+static inline unsigned int
+decrementReferences (VariableNestingLevel *vnl) {
+#ifdef HAVE_SYNC_ADD_AND_FETCH
+  return __sync_sub_and_fetch(&vnl->references, 1);
+#else /* HAVE_SYNC_ADD_AND_FETCH */
+  return --vnl->references;
+#endif /* HAVE_SYNC_ADD_AND_FETCH */
+}
+
 VariableNestingLevel *
 claimVariableNestingLevel (VariableNestingLevel *vnl) {
-  vnl->references += 1;
+  incrementReferences(vnl);
   return vnl;
 }
 
@@ -130,13 +148,13 @@ destroyVariableNestingLevel (VariableNestingLevel *vnl) {
 VariableNestingLevel *
 removeVariableNestingLevel (VariableNestingLevel *vnl) {
   VariableNestingLevel *previous = vnl->previous;
-  if (!--vnl->references) destroyVariableNestingLevel(vnl);
+  if (!decrementReferences(vnl)) destroyVariableNestingLevel(vnl);
   return previous;
 }
 
 void
 releaseVariableNestingLevel (VariableNestingLevel *vnl) {
-  while (vnl && !--vnl->references) {
+  while (vnl && !decrementReferences(vnl)) {
     VariableNestingLevel *previous = vnl->previous;
     destroyVariableNestingLevel(vnl);
     vnl = previous;
@@ -0,0 +1,362 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2022 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "thread.h"
+#include "workpool.h"
+
+struct WorkPoolOutputStruct {
+  unsigned char *bytes;
+  size_t size;
+  size_t count;
+};
+
+typedef enum {
+  WPS_FREE,
+  WPS_PENDING,
+  WPS_BUSY,
+  WPS_DONE
+} WorkPoolSlotState;
+
+typedef struct {
+  WorkPoolSlotState state;
+  int processed;
+
+  struct {
+    unsigned char *bytes;
+    size_t size;
+    size_t count;
+  } input;
+
+  WorkPoolOutput output;
+} WorkPoolSlot;
+
+typedef struct {
+  WorkPool *pool;
+  void *data;
+
+#ifdef GOT_PTHREADS
+  pthread_t thread;
+  unsigned created:1;
+#endif /* GOT_PTHREADS */
+} WorkPoolWorker;
+
+struct WorkPoolStruct {
+  WorkPoolParameters parameters;
+
+  WorkPoolWorker *workers;
+  unsigned int workerCount;
+
+  WorkPoolSlot *slots;
+  unsigned int slotCount;
+
+  /* sequence numbers - the slot for each is its remainder by slotCount */
+  unsigned long int submitted;
+  unsigned long int started;
+  unsigned long int written;
+
+  unsigned failed:1;
+  unsigned stopping:1;
+
+#ifdef GOT_PTHREADS
+  pthread_mutex_t mutex;
+  pthread_cond_t workAvailable;
+  pthread_cond_t workDone;
+#endif /* GOT_PTHREADS */
+};
+
+static int
+ensureBufferSize (unsigned char **bytes, size_t *size, size_t required) {
+  if (required > *size) {
+    size_t newSize = required | 0XFFF;
+    unsigned char *newBytes = realloc(*bytes, newSize);
+
+    if (!newBytes) {
+      logMallocError();
+      return 0;
+    }
+
+    *bytes = newBytes;
+    *size = newSize;
+  }
+
+  return 1;
+}
+
+int
+appendWorkPoolOutput (WorkPoolOutput *output, const void *bytes, size_t count) {
+  if (!ensureBufferSize(&output->bytes, &output->size, (output->count + count))) return 0;
+  memcpy(&output->bytes[output->count], bytes, count);
+  output->count += count;
+  return 1;
+}
+
+static void
+processWorkPoolSlot (WorkPool *pool, WorkPoolSlot *slot, void *data) {
+  slot->output.count = 0;
+  slot->processed = pool->parameters.process(slot->input.bytes, slot->input.count, &slot->output, data);
+}
+
+static void
+writeWorkPoolSlot (WorkPool *pool, WorkPoolSlot *slot) {
+  if (!pool->failed) {
+    if (!slot->processed) {
+      pool->failed = 1;
+    } else if (slot->output.count) {
+      if (!pool->parameters.write(slot->output.bytes, slot->output.count, pool->parameters.writeData)) {
+        pool->failed = 1;
+      }
+    }
+  }
+}
+
+#ifdef GOT_PTHREADS
+static
+THREAD_FUNCTION(runWorkPoolWorker) {
+  WorkPoolWorker *worker = argument;
+  WorkPool *pool = worker->pool;
+
+  pthread_mutex_lock(&pool->mutex);
+
+  while (1) {
+    while (!pool->stopping && (pool->started == pool->submitted)) {
+      pthread_cond_wait(&pool->workAvailable, &pool->mutex);
+    }
+
+    if (pool->stopping) break;
+    WorkPoolSlot *slot = &pool->slots[pool->started++ % pool->slotCount];
+    slot->state = WPS_BUSY;
+
+    pthread_mutex_unlock(&pool->mutex);
+    processWorkPoolSlot(pool, slot, worker->data);
+    pthread_mutex_lock(&pool->mutex);
+
+    slot->state = WPS_DONE;
+    pthread_cond_broadcast(&pool->workDone);
+  }
+
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+/* The mutex must be held. Output is written in submission order, and the
+ * mutex is released while writing so that the workers can carry on.
+ */
+static void
+writeWorkPoolOutput (WorkPool *pool, unsigned long int target, int wait) {
+  while (pool->written < target) {
+    WorkPoolSlot *slot = &pool->slots[pool->written % pool->slotCount];
+
+    if (slot->state != WPS_DONE) {
+      if (!wait) break;
+      pthread_cond_wait(&pool->workDone, &pool->mutex);
+      continue;
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+    writeWorkPoolSlot(pool, slot);
+    pthread_mutex_lock(&pool->mutex);
+
+    slot->state = WPS_FREE;
+    pool->written += 1;
+  }
+}
+
+static void
+stopWorkPoolWorkers (WorkPool *pool) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = 1;
+  pthread_cond_broadcast(&pool->workAvailable);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (unsigned int index=0; index<pool->workerCount; index+=1) {
+    WorkPoolWorker *worker = &pool->workers[index];
+
+    if (worker->created) {
+      pthread_join(worker->thread, NULL);
+      worker->created = 0;
+    }
+  }
+}
+
+static int
+startWorkPoolWorkers (WorkPool *pool) {
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->workAvailable, NULL);
+  pthread_cond_init(&pool->workDone, NULL);
+
+  for (unsigned int index=0; index<pool->workerCount; index+=1) {
+    WorkPoolWorker *worker = &pool->workers[index];
+    char name[0X40];
+
+    snprintf(name, sizeof(name), "%s-%u", pool->parameters.name, index+1);
+    int error = createThread(name, &worker->thread, NULL, runWorkPoolWorker, worker);
+
+    if (error) {
+      logMessage(LOG_ERR, "worker thread not created: %s: %s", name, strerror(error));
+      stopWorkPoolWorkers(pool);
+      return 0;
+    }
+
+    worker->created = 1;
+  }
+
+  return 1;
+}
+
+static void
+destroyWorkPoolSynchronization (WorkPool *pool) {
+  pthread_cond_destroy(&pool->workDone);
+  pthread_cond_destroy(&pool->workAvailable);
+  pthread_mutex_destroy(&pool->mutex);
+}
+#endif /* GOT_PTHREADS */
+
+static void
+deallocateWorkPoolSlots (WorkPool *pool) {
+  for (unsigned int index=0; index<pool->slotCount; index+=1) {
+    WorkPoolSlot *slot = &pool->slots[index];
+
+    if (slot->input.bytes) free(slot->input.bytes);
+    if (slot->output.bytes) free(slot->output.bytes);
+  }
+
+  free(pool->slots);
+}
+
+WorkPool *
+newWorkPool (const WorkPoolParameters *parameters) {
+  WorkPool *pool;
+
+  if ((pool = malloc(sizeof(*pool)))) {
+    memset(pool, 0, sizeof(*pool));
+    pool->parameters = *parameters;
+
+    pool->workerCount = parameters->workerCount;
+    if (!pool->workerCount) pool->workerCount = 1;
+
+#ifndef GOT_PTHREADS
+    /* everything is done by the submitter with the first worker's data */
+    pool->workerCount = 1;
+#endif /* GOT_PTHREADS */
+
+    pool->slotCount = pool->workerCount * 4;
+
+    if ((pool->workers = calloc(pool->workerCount, sizeof(*pool->workers)))) {
+      for (unsigned int index=0; index<pool->workerCount; index+=1) {
+        WorkPoolWorker *worker = &pool->workers[index];
+
+        worker->pool = pool;
+        worker->data = parameters->workerData? parameters->workerData[index]: NULL;
+      }
+
+      if ((pool->slots = calloc(pool->slotCount, sizeof(*pool->slots)))) {
+#ifdef GOT_PTHREADS
+        if (startWorkPoolWorkers(pool)) return pool;
+        destroyWorkPoolSynchronization(pool);
+#else /* GOT_PTHREADS */
+        return pool;
+#endif /* GOT_PTHREADS */
+
+        deallocateWorkPoolSlots(pool);
+      } else {
+        logMallocError();
+      }
+
+      free(pool->workers);
+    } else {
+      logMallocError();
+    }
+
+    free(pool);
+  } else {
+    logMallocError();
+  }
+
+  return NULL;
+}
+
+void
+destroyWorkPool (WorkPool *pool) {
+#ifdef GOT_PTHREADS
+  stopWorkPoolWorkers(pool);
+  destroyWorkPoolSynchronization(pool);
+#endif /* GOT_PTHREADS */
+
+  deallocateWorkPoolSlots(pool);
+  free(pool->workers);
+  free(pool);
+}
+
+int
+submitWorkPoolInput (WorkPool *pool, const void *input, size_t size) {
+  if (pool->failed) return 0;
+
+#ifdef GOT_PTHREADS
+  pthread_mutex_lock(&pool->mutex);
+
+  if ((pool->submitted - pool->written) == pool->slotCount) {
+    writeWorkPoolOutput(pool, (pool->written + 1), 1);
+  }
+
+  pthread_mutex_unlock(&pool->mutex);
+#endif /* GOT_PTHREADS */
+
+  /* the workers don't look at a slot until it has been submitted */
+  WorkPoolSlot *slot = &pool->slots[pool->submitted % pool->slotCount];
+
+  if (!ensureBufferSize(&slot->input.bytes, &slot->input.size, size)) {
+    pool->failed = 1;
+    return 0;
+  }
+
+  memcpy(slot->input.bytes, input, size);
+  slot->input.count = size;
+
+#ifdef GOT_PTHREADS
+  pthread_mutex_lock(&pool->mutex);
+  slot->state = WPS_PENDING;
+  pool->submitted += 1;
+  pthread_cond_signal(&pool->workAvailable);
+  writeWorkPoolOutput(pool, pool->submitted, 0);
+  pthread_mutex_unlock(&pool->mutex);
+#else /* GOT_PTHREADS */
+  processWorkPoolSlot(pool, slot, pool->workers[0].data);
+  writeWorkPoolSlot(pool, slot);
+  pool->submitted += 1;
+  pool->written += 1;
+#endif /* GOT_PTHREADS */
+
+  return !pool->failed;
+}
+
+int
+finishWorkPool (WorkPool *pool) {
+#ifdef GOT_PTHREADS
+  pthread_mutex_lock(&pool->mutex);
+  writeWorkPoolOutput(pool, pool->submitted, 1);
+  pthread_mutex_unlock(&pool->mutex);
+#endif /* GOT_PTHREADS */
+
+  return !pool->failed;
+}